@@ -14,12 +14,19 @@ HEADERS += \
     sources/pluginhandler.h \
     sources/shortcuthandler.h \
     sources/rendertask.h \
+    sources/renderkernels.h \
+    sources/renderscheduler.h \
+    sources/renderstatistics.h \
+    sources/diskcache.h \
+    sources/memorymanager.h \
     sources/tileitem.h \
     sources/pageitem.h \
     sources/thumbnailitem.h \
     sources/presentationview.h \
     sources/searchmodel.h \
     sources/searchtask.h \
+    sources/searchindex.h \
+    sources/documentloader.h \
     sources/miscellaneous.h \
     sources/documentlayout.h \
     sources/documentview.h \
@@ -40,12 +47,19 @@ SOURCES += \
     sources/pluginhandler.cpp \
     sources/shortcuthandler.cpp \
     sources/rendertask.cpp \
+    sources/renderkernels.cpp \
+    sources/renderscheduler.cpp \
+    sources/renderstatistics.cpp \
+    sources/diskcache.cpp \
+    sources/memorymanager.cpp \
     sources/tileitem.cpp \
     sources/pageitem.cpp \
     sources/thumbnailitem.cpp \
     sources/presentationview.cpp \
     sources/searchmodel.cpp \
     sources/searchtask.cpp \
+    sources/searchindex.cpp \
+    sources/documentloader.cpp \
     sources/miscellaneous.cpp \
     sources/documentlayout.cpp \
     sources/documentview.cpp \
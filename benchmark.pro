@@ -0,0 +1,65 @@
+include(qpdfview.pri)
+
+TARGET = qpdfview-bench
+TEMPLATE = app
+
+OBJECTS_DIR = objects-benchmark
+MOC_DIR = moc-benchmark
+
+HEADERS += \
+    sources/global.h \
+    sources/model.h \
+    sources/pluginhandler.h \
+    sources/rendertask.h \
+    sources/renderkernels.h \
+    sources/renderscheduler.h \
+    sources/renderstatistics.h \
+    sources/diskcache.h
+
+SOURCES += \
+    sources/pluginhandler.cpp \
+    sources/rendertask.cpp \
+    sources/renderkernels.cpp \
+    sources/renderscheduler.cpp \
+    sources/renderstatistics.cpp \
+    sources/diskcache.cpp \
+    sources/benchmark.cpp
+
+QT += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+DEFINES += PLUGIN_INSTALL_PATH=\\\"$${PLUGIN_INSTALL_PATH}\\\"
+
+!without_pdf {
+    DEFINES += WITH_PDF
+
+    isEmpty(PDF_PLUGIN_NAME):PDF_PLUGIN_NAME = libqpdfview_pdf.so
+    DEFINES += PDF_PLUGIN_NAME=\\\"$${PDF_PLUGIN_NAME}\\\"
+}
+
+!without_ps {
+    DEFINES += WITH_PS
+
+    isEmpty(PS_PLUGIN_NAME):PS_PLUGIN_NAME = libqpdfview_ps.so
+    DEFINES += PS_PLUGIN_NAME=\\\"$${PS_PLUGIN_NAME}\\\"
+}
+
+!without_djvu {
+    DEFINES += WITH_DJVU
+
+    isEmpty(DJVU_PLUGIN_NAME):DJVU_PLUGIN_NAME = libqpdfview_djvu.so
+    DEFINES += DJVU_PLUGIN_NAME=\\\"$${DJVU_PLUGIN_NAME}\\\"
+}
+
+with_fitz {
+    DEFINES += WITH_FITZ
+
+    isEmpty(FITZ_PLUGIN_NAME):FITZ_PLUGIN_NAME = libqpdfview_fitz.so
+    DEFINES += FITZ_PLUGIN_NAME=\\\"$${FITZ_PLUGIN_NAME}\\\"
+}
+
+lessThan(QT_MAJOR_VERSION, 5) : !without_magic {
+    DEFINES += WITH_MAGIC
+    LIBS += -lmagic
+}
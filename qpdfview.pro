@@ -25,6 +25,10 @@ with_fitz {
 
 SUBDIRS += application.pro
 
+with_benchmark {
+    SUBDIRS += benchmark.pro
+}
+
 TRANSLATIONS += \
     translations/qpdfview_ast.ts \
     translations/qpdfview_az.ts \
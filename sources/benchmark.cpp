@@ -0,0 +1,679 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include <algorithm>
+#include <iostream>
+
+#include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QScopedPointer>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+
+#ifdef Q_OS_UNIX
+
+#include <sys/resource.h>
+
+#endif // Q_OS_UNIX
+
+#include "global.h"
+#include "model.h"
+#include "pluginhandler.h"
+#include "renderkernels.h"
+#include "renderstatistics.h"
+#include "rendertask.h"
+
+namespace
+{
+
+using namespace qpdfview;
+
+enum ExitStatus
+{
+    ExitOk = 0,
+    ExitUnknownArgument = 1,
+    ExitIllegalArgument = 2,
+    ExitInconsistentArguments = 3,
+    ExitLoadError = 4
+};
+
+QString filePath;
+
+int firstPage = 1;
+int lastPage = -1;
+
+QList< int > resolutions;
+QList< Rotation > rotations;
+QList< int > tileSizes;
+
+int threadCount = QThread::idealThreadCount();
+
+bool benchmarkKernels = false;
+
+QList< int > parseNumbers(const QString& argument, bool& ok)
+{
+    QList< int > numbers;
+
+    foreach(const QString& field, argument.split(QLatin1Char(','), QString::SkipEmptyParts))
+    {
+        const int number = field.toInt(&ok);
+
+        if(!ok || number < 0)
+        {
+            ok = false;
+            return QList< int >();
+        }
+
+        numbers.append(number);
+    }
+
+    ok = !numbers.isEmpty();
+    return numbers;
+}
+
+void parseCommandLineArguments()
+{
+    QStringList arguments = QApplication::arguments();
+
+    if(!arguments.isEmpty())
+    {
+        arguments.removeFirst();
+    }
+
+    for(int index = 0; index < arguments.count(); ++index)
+    {
+        const QString& argument = arguments.at(index);
+
+        if(argument == QLatin1String("--help"))
+        {
+            std::cout << "Usage: qpdfview-bench [options] file" << std::endl
+                      << std::endl
+                      << "Available options:" << std::endl
+                      << "  --help                      Show this information" << std::endl
+                      << "  --pages first-last          Render only the given range of pages" << std::endl
+                      << "  --resolutions dpi,...       Render at the given resolutions (default: 72)" << std::endl
+                      << "  --rotations degrees,...     Render with the given rotations (default: 0)" << std::endl
+                      << "  --tile-sizes pixels,...     Render tiles of the given sizes, 0 meaning whole pages (default: 0)" << std::endl
+                      << "  --threads count             Render on the given number of threads (default: ideal thread count)" << std::endl
+                      << "  --kernels                   Measure the per-pixel kernels on synthetic pages, the file is optional then" << std::endl;
+
+            exit(ExitOk);
+        }
+        else if(argument == QLatin1String("--kernels"))
+        {
+            benchmarkKernels = true;
+        }
+        else if(argument.startsWith(QLatin1String("--")))
+        {
+            if(index + 1 == arguments.count())
+            {
+                qCritical() << QObject::tr("Using '%1' requires a value.").arg(argument);
+                exit(ExitInconsistentArguments);
+            }
+
+            const QString value = arguments.at(++index);
+            bool ok = false;
+
+            if(argument == QLatin1String("--pages"))
+            {
+                const QList< int > pages = parseNumbers(value.section(QLatin1Char('-'), 0, 0) + QLatin1Char(',') + value.section(QLatin1Char('-'), 1, 1), ok);
+
+                ok = ok && pages.count() == 2 && pages.at(0) >= 1 && pages.at(0) <= pages.at(1);
+
+                if(ok)
+                {
+                    firstPage = pages.at(0);
+                    lastPage = pages.at(1);
+                }
+            }
+            else if(argument == QLatin1String("--resolutions"))
+            {
+                resolutions = parseNumbers(value, ok);
+
+                ok = ok && !resolutions.contains(0);
+            }
+            else if(argument == QLatin1String("--rotations"))
+            {
+                foreach(int degrees, parseNumbers(value, ok))
+                {
+                    ok = ok && degrees % 90 == 0 && degrees < 360;
+
+                    rotations.append(static_cast< Rotation >(degrees / 90));
+                }
+            }
+            else if(argument == QLatin1String("--tile-sizes"))
+            {
+                tileSizes = parseNumbers(value, ok);
+            }
+            else if(argument == QLatin1String("--threads"))
+            {
+                threadCount = value.toInt(&ok);
+
+                ok = ok && threadCount > 0;
+            }
+            else
+            {
+                qCritical() << QObject::tr("Unknown command-line option '%1'.").arg(argument);
+                exit(ExitUnknownArgument);
+            }
+
+            if(!ok)
+            {
+                qCritical() << QObject::tr("Illegal value '%1' for '%2'.").arg(value, argument);
+                exit(ExitIllegalArgument);
+            }
+        }
+        else if(filePath.isEmpty())
+        {
+            filePath = argument;
+        }
+        else
+        {
+            qCritical() << QObject::tr("Only a single file can be benchmarked.");
+            exit(ExitInconsistentArguments);
+        }
+    }
+
+    if(filePath.isEmpty() && !benchmarkKernels)
+    {
+        qCritical() << QObject::tr("A file to benchmark is required.");
+        exit(ExitInconsistentArguments);
+    }
+
+    if(resolutions.isEmpty())
+    {
+        resolutions.append(72);
+    }
+
+    if(rotations.isEmpty())
+    {
+        rotations.append(RotateBy0);
+    }
+
+    if(tileSizes.isEmpty())
+    {
+        tileSizes.append(0);
+    }
+}
+
+QList< QRect > tileRects(const Model::Page* page, int resolution, Rotation rotation, int tileSize)
+{
+    QSizeF size = page->size() * resolution / 72.0;
+
+    if(rotation == RotateBy90 || rotation == RotateBy270)
+    {
+        size.transpose();
+    }
+
+    const QRect pageRect(QPoint(), size.toSize());
+
+    QList< QRect > rects;
+
+    if(tileSize <= 0)
+    {
+        rects.append(QRect());
+
+        return rects;
+    }
+
+    for(int top = 0; top < pageRect.height(); top += tileSize)
+    {
+        for(int left = 0; left < pageRect.width(); left += tileSize)
+        {
+            rects.append(QRect(left, top, tileSize, tileSize).intersected(pageRect));
+        }
+    }
+
+    return rects;
+}
+
+class Job : public QRunnable
+{
+public:
+    Job(Model::Page* page, const RenderParam& renderParam, const QRect& rect, qint64& latency) : QRunnable(),
+        m_page(page),
+        m_renderParam(renderParam),
+        m_rect(rect),
+        m_latency(latency)
+    {
+    }
+
+    void run()
+    {
+        // the tile is rendered by a render task exactly like a visible tile would be, but on this thread
+
+        RenderTask renderTask(m_page);
+
+        renderTask.prepare(m_renderParam, m_rect, false, false, false, false, Qt::white);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        renderTask.run();
+
+        m_latency = timer.elapsed();
+    }
+
+private:
+    Q_DISABLE_COPY(Job)
+
+    Model::Page* m_page;
+    RenderParam m_renderParam;
+    QRect m_rect;
+
+    qint64& m_latency;
+
+};
+
+qint64 percentile(const QVector< qint64 >& sortedLatencies, int percent)
+{
+    return sortedLatencies.isEmpty() ? 0 : sortedLatencies.at((sortedLatencies.count() - 1) * percent / 100);
+}
+
+long peakResidentSetSize()
+{
+#ifdef Q_OS_UNIX
+
+    struct rusage usage;
+
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        return usage.ru_maxrss;
+    }
+
+#endif // Q_OS_UNIX
+
+    return -1;
+}
+
+void benchmark(const QVector< Model::Page* >& pages, int resolution, Rotation rotation, int tileSize)
+{
+    QList< QPair< Model::Page*, QRect > > tiles;
+
+    foreach(Model::Page* page, pages)
+    {
+        foreach(const QRect& rect, tileRects(page, resolution, rotation, tileSize))
+        {
+            tiles.append(qMakePair(page, rect));
+        }
+    }
+
+    const RenderParam renderParam(RenderResolution(resolution, resolution), 1.0, rotation);
+
+    QVector< qint64 > latencies(tiles.count(), 0);
+
+    // each job runs its render task itself, so no second thread pool is involved
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(threadCount);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for(int index = 0; index < tiles.count(); ++index)
+    {
+        threadPool.start(new Job(tiles.at(index).first, renderParam, tiles.at(index).second, latencies[index]));
+    }
+
+    threadPool.waitForDone();
+
+    const qint64 elapsed = qMax(timer.elapsed(), Q_INT64_C(1));
+
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << "resolution " << resolution << " dpi, "
+              << "rotation " << 90 * static_cast< int >(rotation) << " degrees, "
+              << "tile size " << tileSize << ": "
+              << pages.count() << " pages, " << tiles.count() << " tiles in " << elapsed << " ms, "
+              << 1000.0 * pages.count() / elapsed << " pages/s, "
+              << "p50 " << percentile(latencies, 50) << " ms, "
+              << "p99 " << percentile(latencies, 99) << " ms" << std::endl;
+}
+
+// kernels
+
+const int kernelRepetitions = 20;
+
+QImage syntheticPage(const QSize& size)
+{
+    // lines of text within margins of a tenth of the page
+
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(0xffffffffu);
+
+    QPainter painter(&image);
+
+    const int left = size.width() / 10;
+    const int top = size.height() / 10;
+    const int width = size.width() - 2 * left;
+    const int lineHeight = qMax(size.height() / 80, 2);
+
+    for(int line = 0, y = top; y + lineHeight <= size.height() - top; ++line, y += 2 * lineHeight)
+    {
+        painter.fillRect(left, y, width * (5 + line % 3) / 7, lineHeight, QColor(32, 32, 32));
+    }
+
+    return image;
+}
+
+// the per-pixel implementation that the scan line kernel replaced
+
+bool columnHasPaperColor(int x, QRgb paperColor, const QImage& image)
+{
+    const int height = image.height();
+
+    for(int y = 0; y < height; ++y)
+    {
+        if(paperColor != (image.pixel(x, y) | 0xff000000u))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool rowHasPaperColor(int y, QRgb paperColor, const QImage& image)
+{
+    const int width = image.width();
+
+    for(int x = 0; x < width; ++x)
+    {
+        if(paperColor != (image.pixel(x, y) | 0xff000000u))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QRectF trimMarginsPerPixel(QRgb paperColor, const QImage& image)
+{
+    const int width = image.width();
+    const int height = image.height();
+
+    int left;
+    for(left = 0; left < width; ++left)
+    {
+        if(!columnHasPaperColor(left, paperColor, image))
+        {
+            break;
+        }
+    }
+    left = qMin(left, width / 3);
+
+    int right;
+    for(right = width - 1; right >= left; --right)
+    {
+        if(!columnHasPaperColor(right, paperColor, image))
+        {
+            break;
+        }
+    }
+    right = qMax(right, 2 * width / 3);
+
+    int top;
+    for(top = 0; top < height; ++top)
+    {
+        if(!rowHasPaperColor(top, paperColor, image))
+        {
+            break;
+        }
+    }
+    top = qMin(top, height / 3);
+
+    int bottom;
+    for(bottom = height - 1; bottom >= top; --bottom)
+    {
+        if(!rowHasPaperColor(bottom, paperColor, image))
+        {
+            break;
+        }
+    }
+    bottom = qMax(bottom, 2 * height / 3);
+
+    left = qMax(left - width / 100, 0);
+    top = qMax(top - height / 100, 0);
+
+    right = qMin(right + width / 100, width);
+    bottom = qMin(bottom + height / 100, height);
+
+    return QRectF(static_cast< qreal >(left) / width,
+                  static_cast< qreal >(top) / height,
+                  static_cast< qreal >(right - left) / width,
+                  static_cast< qreal >(bottom - top) / height);
+}
+
+void printMilliseconds(const char* name, qint64 nanoseconds)
+{
+    std::cout << ", " << name << " " << nanoseconds / 1000000.0 << " ms";
+}
+
+void benchmarkTrimMargins(const QImage& image)
+{
+    const QRgb paperColor = qRgb(255, 255, 255);
+
+    std::cout << "trim margins " << image.width() << "x" << image.height();
+
+    QElapsedTimer timer;
+    qint64 fastest = Q_INT64_C(0x7fffffffffffffff);
+
+    for(int repetition = 0; repetition < kernelRepetitions; ++repetition)
+    {
+        timer.start();
+        trimMarginsPerPixel(paperColor, image);
+        fastest = qMin(fastest, timer.nsecsElapsed());
+    }
+
+    printMilliseconds("per pixel", fastest);
+
+    const QRectF expected = trimMarginsPerPixel(paperColor, image);
+
+    for(int instructionSet = ScalarInstructions; instructionSet <= supportedInstructionSet(); ++instructionSet)
+    {
+        fastest = Q_INT64_C(0x7fffffffffffffff);
+
+        for(int repetition = 0; repetition < kernelRepetitions; ++repetition)
+        {
+            timer.start();
+            trimMargins(paperColor, image, static_cast< InstructionSet >(instructionSet));
+            fastest = qMin(fastest, timer.nsecsElapsed());
+        }
+
+        printMilliseconds(instructionSetName(static_cast< InstructionSet >(instructionSet)), fastest);
+
+        if(trimMargins(paperColor, image, static_cast< InstructionSet >(instructionSet)) != expected)
+        {
+            std::cout << " (mismatch)";
+        }
+    }
+
+    std::cout << std::endl;
+}
+
+// the two passes that the fused filter kernel replaced
+
+void applyFiltersTwoPasses(QImage& image)
+{
+    QRgb* const begin = reinterpret_cast< QRgb* >(image.bits());
+    QRgb* const end = reinterpret_cast< QRgb* >(image.bits() + image.byteCount());
+
+    for(QRgb* pointer = begin; pointer != end; ++pointer)
+    {
+        const int gray = qGray(*pointer);
+        const int alpha = qAlpha(*pointer);
+
+        *pointer = qRgba(gray, gray, gray, alpha);
+    }
+
+    image.invertPixels();
+}
+
+void benchmarkApplyFilters(const QImage& image)
+{
+    const int filters = GrayscaleFilter | InvertFilter;
+
+    std::cout << "filters " << image.width() << "x" << image.height();
+
+    QElapsedTimer timer;
+    qint64 fastest = Q_INT64_C(0x7fffffffffffffff);
+
+    QImage expected;
+
+    for(int repetition = 0; repetition < kernelRepetitions; ++repetition)
+    {
+        expected = image.copy();
+
+        timer.start();
+        applyFiltersTwoPasses(expected);
+        fastest = qMin(fastest, timer.nsecsElapsed());
+    }
+
+    printMilliseconds("two passes", fastest);
+
+    for(int instructionSet = ScalarInstructions; instructionSet <= supportedInstructionSet(); ++instructionSet)
+    {
+        fastest = Q_INT64_C(0x7fffffffffffffff);
+
+        QImage filtered;
+
+        for(int repetition = 0; repetition < kernelRepetitions; ++repetition)
+        {
+            filtered = image.copy();
+
+            timer.start();
+            applyFilters(filtered, filters, static_cast< InstructionSet >(instructionSet));
+            fastest = qMin(fastest, timer.nsecsElapsed());
+        }
+
+        printMilliseconds(instructionSetName(static_cast< InstructionSet >(instructionSet)), fastest);
+
+        if(filtered != expected)
+        {
+            std::cout << " (mismatch)";
+        }
+    }
+
+    std::cout << std::endl;
+}
+
+void benchmarkAllKernels()
+{
+    // A4 at 150 and 300 dpi as well as a typical tile
+
+    QList< QSize > sizes;
+    sizes << QSize(1240, 1754) << QSize(2480, 3508) << QSize(1024, 1024);
+
+    std::cout << "kernels, fastest of " << kernelRepetitions << " repetitions, "
+              << "supported instruction set " << instructionSetName(supportedInstructionSet()) << std::endl;
+
+    foreach(const QSize& size, sizes)
+    {
+        const QImage image = syntheticPage(size);
+
+        benchmarkTrimMargins(image);
+        benchmarkApplyFilters(image);
+    }
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+    qRegisterMetaType< Rotation >("Rotation");
+    qRegisterMetaType< RenderParam >("RenderParam");
+
+    QApplication application(argc, argv);
+
+    QApplication::setOrganizationDomain("local.qpdfview");
+    QApplication::setOrganizationName("qpdfview");
+    QApplication::setApplicationName("qpdfview-bench");
+
+    parseCommandLineArguments();
+
+    // the measured latencies should not include the bookkeeping of the statistics overlay
+
+    RenderStatistics::setEnabled(false);
+
+    if(benchmarkKernels)
+    {
+        benchmarkAllKernels();
+
+        if(filePath.isEmpty())
+        {
+            return ExitOk;
+        }
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(threadCount);
+
+    QScopedPointer< Model::Document > document(PluginHandler::instance()->loadDocument(filePath));
+
+    if(document.isNull() || document->isLocked())
+    {
+        qCritical() << QObject::tr("Could not load '%1'.").arg(filePath);
+        return ExitLoadError;
+    }
+
+    if(lastPage == -1 || lastPage > document->numberOfPages())
+    {
+        lastPage = document->numberOfPages();
+    }
+
+    QVector< Model::Page* > pages;
+
+    for(int index = firstPage - 1; index < lastPage; ++index)
+    {
+        Model::Page* page = document->page(index);
+
+        if(page == 0)
+        {
+            qCritical() << QObject::tr("Could not load page %1 of '%2'.").arg(index + 1).arg(filePath);
+            return ExitLoadError;
+        }
+
+        pages.append(page);
+    }
+
+    std::cout << "threads " << threadCount << std::endl;
+
+    foreach(int resolution, resolutions)
+    {
+        foreach(Rotation rotation, rotations)
+        {
+            foreach(int tileSize, tileSizes)
+            {
+                benchmark(pages, resolution, rotation, tileSize);
+            }
+        }
+    }
+
+    std::cout << "peak resident set size " << peakResidentSetSize() << " KiB" << std::endl;
+
+    qDeleteAll(pages);
+
+    return ExitOk;
+}
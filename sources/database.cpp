@@ -487,6 +487,88 @@ void Database::savePerFileSettings(const DocumentView* tab)
 #endif // WITH_SQL
 }
 
+QByteArray Database::loadSearchIndex(const QString& absoluteFilePath, const QDateTime& lastModified)
+{
+    QByteArray searchIndex;
+
+#ifdef WITH_SQL
+
+    if(Settings::instance()->mainWindow().restoreSearchIndex() && m_database.isOpen())
+    {
+        Transaction transaction(m_database);
+
+        QSqlQuery query(m_database);
+        query.prepare("SELECT searchIndex FROM searchindex_v3 WHERE filePath==? AND modified==?");
+
+        query.bindValue(0, QCryptographicHash::hash(absoluteFilePath.toUtf8(), QCryptographicHash::Sha1).toBase64());
+        query.bindValue(1, lastModified.toTime_t());
+
+        query.exec();
+
+        if(query.next())
+        {
+            searchIndex = query.value(0).toByteArray();
+        }
+
+        if(!query.isActive())
+        {
+            qDebug() << query.lastError();
+            return QByteArray();
+        }
+
+        transaction.commit();
+    }
+
+#else
+
+    Q_UNUSED(absoluteFilePath);
+    Q_UNUSED(lastModified);
+
+#endif // WITH_SQL
+
+    return searchIndex;
+}
+
+void Database::saveSearchIndex(const QString& absoluteFilePath, const QDateTime& lastModified, const QByteArray& searchIndex)
+{
+#ifdef WITH_SQL
+
+    if(Settings::instance()->mainWindow().restoreSearchIndex() && m_database.isOpen())
+    {
+        Transaction transaction(m_database);
+
+        QSqlQuery query(m_database);
+        query.prepare("INSERT OR REPLACE INTO searchindex_v3 "
+                      "(lastUsed,filePath,modified,searchIndex)"
+                      " VALUES (?,?,?,?)");
+
+        query.bindValue(0, QDateTime::currentDateTime().toTime_t());
+
+        query.bindValue(1, QCryptographicHash::hash(absoluteFilePath.toUtf8(), QCryptographicHash::Sha1).toBase64());
+        query.bindValue(2, lastModified.toTime_t());
+
+        query.bindValue(3, searchIndex);
+
+        query.exec();
+
+        if(!query.isActive())
+        {
+            qDebug() << query.lastError();
+            return;
+        }
+
+        transaction.commit();
+    }
+
+#else
+
+    Q_UNUSED(absoluteFilePath);
+    Q_UNUSED(lastModified);
+    Q_UNUSED(searchIndex);
+
+#endif // WITH_SQL
+}
+
 Database::Database(QObject* parent) : QObject(parent)
 {
 #ifdef WITH_SQL
@@ -569,6 +651,15 @@ Database::Database(QObject* parent) : QObject(parent)
         }
 
         limitPerFileSettings();
+
+        // search index
+
+        if(!tables.contains("searchindex_v3"))
+        {
+            prepareSearchIndex_v3();
+        }
+
+        limitSearchIndex();
     }
     else
     {
@@ -661,6 +752,28 @@ bool Database::preparePerFileSettings_v3()
     return true;
 }
 
+bool Database::prepareSearchIndex_v3()
+{
+    Transaction transaction(m_database);
+
+    QSqlQuery query(m_database);
+
+    query.exec("CREATE TABLE searchindex_v3 "
+               "(lastUsed INTEGER"
+               ",filePath TEXT PRIMARY KEY"
+               ",modified INTEGER"
+               ",searchIndex BLOB)");
+
+    if(!query.isActive())
+    {
+        qDebug() << query.lastError();
+        return false;
+    }
+
+    transaction.commit();
+    return true;
+}
+
 void Database::migrateTabs_v2_v3()
 {
     Transaction transaction(m_database);
@@ -851,6 +964,30 @@ void Database::limitPerFileSettings()
     transaction.commit();
 }
 
+void Database::limitSearchIndex()
+{
+    Transaction transaction(m_database);
+
+    QSqlQuery query(m_database);
+
+    if(Settings::instance()->mainWindow().restoreSearchIndex())
+    {
+        query.exec("DELETE FROM searchindex_v3 WHERE filePath NOT IN (SELECT filePath FROM searchindex_v3 ORDER BY lastUsed DESC LIMIT 100)");
+    }
+    else
+    {
+        query.exec("DELETE FROM searchindex_v3");
+    }
+
+    if(!query.isActive())
+    {
+        qDebug() << query.lastError();
+        return;
+    }
+
+    transaction.commit();
+}
+
 #endif // WITH_SQL
 
 } // qpdfview
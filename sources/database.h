@@ -61,6 +61,9 @@ public:
     void restorePerFileSettings(DocumentView* tab);
     void savePerFileSettings(const DocumentView* tab);
 
+    QByteArray loadSearchIndex(const QString& absoluteFilePath, const QDateTime& lastModified);
+    void saveSearchIndex(const QString& absoluteFilePath, const QDateTime& lastModified, const QByteArray& searchIndex);
+
 signals:
     void tabRestored(const QString& absoluteFilePath, bool continuousMode, LayoutMode layoutMode, bool rightToLeftMode, ScaleMode scaleMode, qreal scaleFactor, Rotation rotation, int currentPage);
 
@@ -77,6 +80,7 @@ private:
     bool prepareTabs_v3();
     bool prepareBookmarks_v3();
     bool preparePerFileSettings_v3();
+    bool prepareSearchIndex_v3();
 
     void migrateTabs_v2_v3();
     void migrateTabs_v1_v3();
@@ -86,6 +90,7 @@ private:
     void migratePerFileSettings_v1_v3();
 
     void limitPerFileSettings();
+    void limitSearchIndex();
 
     QSqlDatabase m_database;
 
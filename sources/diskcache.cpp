@@ -0,0 +1,393 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "diskcache.h"
+
+#include <cstring>
+
+#include <QApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+
+#include <QStandardPaths>
+
+#else
+
+#include <QDesktopServices>
+
+#endif // QT_VERSION
+
+namespace
+{
+
+const quint32 magicNumber = 0x71706463;
+const quint32 formatVersion = 1;
+
+const int maximumPendingItems = 64;
+
+QString fileName(const QByteArray& key)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex());
+}
+
+QString partialSuffix()
+{
+    return QLatin1String(".part");
+}
+
+} // anonymous
+
+namespace qpdfview
+{
+
+DiskCache* DiskCache::s_instance = 0;
+
+DiskCache* DiskCache::instance()
+{
+    if(s_instance == 0)
+    {
+        s_instance = new DiskCache(qApp);
+    }
+
+    return s_instance;
+}
+
+DiskCache::~DiskCache()
+{
+    m_mutex.lock();
+    m_quit = true;
+    m_mutex.unlock();
+
+    m_waitCondition.wakeAll();
+
+    wait();
+
+    s_instance = 0;
+}
+
+void DiskCache::setMaximumSize(qint64 maximumSize)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    m_maximumSize = qMax(maximumSize, Q_INT64_C(0));
+
+    if(m_maximumSize == 0)
+    {
+        m_pendingItems.clear();
+    }
+
+    evictEntries();
+}
+
+bool DiskCache::load(const QByteArray& key, QImage& image, QRectF& cropRect)
+{
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        if(m_maximumSize <= 0)
+        {
+            return false;
+        }
+    }
+
+    const QString name = fileName(key);
+
+    QFile file(QDir(m_path).filePath(name));
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+
+    stream >> magic >> version;
+
+    if(magic != magicNumber || version != formatVersion)
+    {
+        return false;
+    }
+
+    QRectF loadedCropRect;
+    qint32 width = 0;
+    qint32 height = 0;
+    qint32 format = 0;
+    QByteArray data;
+
+    stream >> loadedCropRect >> width >> height >> format >> data;
+
+    if(stream.status() != QDataStream::Ok)
+    {
+        return false;
+    }
+
+    data = qUncompress(data);
+
+    QImage loadedImage(width, height, static_cast< QImage::Format >(format));
+
+    if(loadedImage.isNull() || loadedImage.byteCount() != data.size())
+    {
+        return false;
+    }
+
+    memcpy(loadedImage.bits(), data.constData(), data.size());
+
+    image = loadedImage;
+    cropRect = loadedCropRect;
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    touchEntry(name);
+
+    return true;
+}
+
+void DiskCache::store(const QByteArray& key, const QImage& image, const QRectF& cropRect)
+{
+    if(image.isNull())
+    {
+        return;
+    }
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    // writing is best effort, so drop items instead of piling up images in memory
+
+    if(m_maximumSize <= 0 || m_pendingItems.count() >= maximumPendingItems)
+    {
+        return;
+    }
+
+    m_pendingItems.append(Item(fileName(key), image, cropRect));
+
+    m_waitCondition.wakeOne();
+}
+
+void DiskCache::run()
+{
+    loadEntries();
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    while(true)
+    {
+        while(m_pendingItems.isEmpty() && !m_quit)
+        {
+            m_waitCondition.wait(&m_mutex);
+        }
+
+        if(m_quit)
+        {
+            break;
+        }
+
+        const Item item = m_pendingItems.takeFirst();
+
+        mutexLocker.unlock();
+
+        const qint64 size = write(item);
+
+        mutexLocker.relock();
+
+        if(size > 0)
+        {
+            insertEntry(item.name, size);
+            evictEntries();
+        }
+    }
+}
+
+DiskCache::DiskCache(QObject* parent) : QThread(parent),
+    m_path(),
+    m_mutex(),
+    m_waitCondition(),
+    m_quit(false),
+    m_maximumSize(-1),
+    m_size(0),
+    m_lastUse(0),
+    m_entriesByLastUse(),
+    m_entries(),
+    m_pendingItems()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+
+    const QString path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+#else
+
+    const QString path = QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+
+#endif // QT_VERSION
+
+    m_path = QDir(path).filePath("tiles");
+
+    QDir().mkpath(m_path);
+
+    start(QThread::LowestPriority);
+}
+
+void DiskCache::loadEntries()
+{
+    const QFileInfoList fileInfos = QDir(m_path).entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    // entries used during this session are more recent than anything found on disk,
+    // so the latter are ordered below every key already taken and below zero
+
+    qint64 lastUse = -fileInfos.count() - 1;
+
+    if(!m_entriesByLastUse.isEmpty())
+    {
+        lastUse += qMin(qint64(0), m_entriesByLastUse.firstKey());
+    }
+
+    foreach(const QFileInfo& fileInfo, fileInfos)
+    {
+        const QString name = fileInfo.fileName();
+
+        ++lastUse;
+
+        if(name.endsWith(partialSuffix()))
+        {
+            QFile::remove(fileInfo.absoluteFilePath());
+
+            continue;
+        }
+
+        if(m_entries.contains(name))
+        {
+            continue;
+        }
+
+        m_entriesByLastUse.insert(lastUse, name);
+        m_entries.insert(name, Entry(fileInfo.size(), lastUse));
+        m_size += fileInfo.size();
+    }
+
+    evictEntries();
+}
+
+void DiskCache::touchEntry(const QString& name)
+{
+    const QHash< QString, Entry >::iterator entry = m_entries.find(name);
+
+    if(entry != m_entries.end())
+    {
+        m_entriesByLastUse.remove(entry->lastUse);
+
+        entry->lastUse = m_lastUse++;
+        m_entriesByLastUse.insert(entry->lastUse, name);
+    }
+}
+
+void DiskCache::insertEntry(const QString& name, qint64 size)
+{
+    const QHash< QString, Entry >::iterator entry = m_entries.find(name);
+
+    if(entry != m_entries.end())
+    {
+        m_size -= entry->size;
+
+        m_entriesByLastUse.remove(entry->lastUse);
+    }
+
+    const qint64 lastUse = m_lastUse++;
+
+    m_entriesByLastUse.insert(lastUse, name);
+    m_entries.insert(name, Entry(size, lastUse));
+    m_size += size;
+}
+
+void DiskCache::evictEntries()
+{
+    // the maximum size is not known until the first document was opened
+
+    if(m_maximumSize < 0)
+    {
+        return;
+    }
+
+    while(m_size > m_maximumSize && !m_entriesByLastUse.isEmpty())
+    {
+        const QString name = m_entriesByLastUse.take(m_entriesByLastUse.firstKey());
+
+        m_size -= m_entries.take(name).size;
+
+        QFile::remove(QDir(m_path).filePath(name));
+    }
+}
+
+qint64 DiskCache::write(const Item& item) const
+{
+    const QString filePath = QDir(m_path).filePath(item.name);
+    const QString partialFilePath = filePath + partialSuffix();
+
+    // write to a partial file first so that concurrent readers never see incomplete data
+
+    QFile file(partialFilePath);
+
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return -1;
+    }
+
+    const QImage& image = item.image;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    stream << magicNumber << formatVersion << item.cropRect
+           << qint32(image.width()) << qint32(image.height()) << qint32(image.format())
+           << qCompress(image.constBits(), image.byteCount(), 1);
+
+    file.close();
+
+    if(stream.status() != QDataStream::Ok || file.error() != QFile::NoError)
+    {
+        QFile::remove(partialFilePath);
+
+        return -1;
+    }
+
+    QFile::remove(filePath);
+
+    if(!QFile::rename(partialFilePath, filePath))
+    {
+        QFile::remove(partialFilePath);
+
+        return -1;
+    }
+
+    return QFileInfo(filePath).size();
+}
+
+} // qpdfview
@@ -0,0 +1,109 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef DISKCACHE_H
+#define DISKCACHE_H
+
+#include <QHash>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QRectF>
+#include <QThread>
+#include <QWaitCondition>
+
+namespace qpdfview
+{
+
+class DiskCache : public QThread
+{
+    Q_OBJECT
+
+public:
+    static DiskCache* instance();
+    ~DiskCache();
+
+    void setMaximumSize(qint64 maximumSize);
+
+    bool load(const QByteArray& key, QImage& image, QRectF& cropRect);
+    void store(const QByteArray& key, const QImage& image, const QRectF& cropRect);
+
+protected:
+    void run();
+
+private:
+    Q_DISABLE_COPY(DiskCache)
+
+    static DiskCache* s_instance;
+    DiskCache(QObject* parent = 0);
+
+    QString m_path;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_waitCondition;
+
+    bool m_quit;
+
+    qint64 m_maximumSize;
+    qint64 m_size;
+
+    // entries are ordered by their last use so that touching one is logarithmic instead of linear
+
+    struct Entry
+    {
+        qint64 size;
+        qint64 lastUse;
+
+        Entry() : size(0), lastUse(0) {}
+        Entry(qint64 size, qint64 lastUse) : size(size), lastUse(lastUse) {}
+
+    };
+
+    qint64 m_lastUse;
+    QMap< qint64, QString > m_entriesByLastUse;
+    QHash< QString, Entry > m_entries;
+
+    void loadEntries();
+    void touchEntry(const QString& name);
+    void insertEntry(const QString& name, qint64 size);
+    void evictEntries();
+
+    struct Item
+    {
+        QString name;
+        QImage image;
+        QRectF cropRect;
+
+        Item() : name(), image(), cropRect() {}
+        Item(const QString& name, const QImage& image, const QRectF& cropRect) : name(name), image(image), cropRect(cropRect) {}
+
+    };
+
+    QList< Item > m_pendingItems;
+
+    qint64 write(const Item& item) const;
+
+};
+
+} // qpdfview
+
+#endif // DISKCACHE_H
@@ -28,7 +28,10 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include <cstdio>
 
 #include <QFile>
+#include <QFormLayout>
 #include <qmath.h>
+#include <QSettings>
+#include <QSpinBox>
 
 #include <libdjvu/ddjvuapi.h>
 #include <libdjvu/miniexp.h>
@@ -53,6 +56,9 @@ namespace
 
 using namespace qpdfview::Model;
 
+const int defaultDecodedPages = 4;
+const int maximumThumbnailExtent = 256;
+
 inline miniexp_t miniexp_cadddr(miniexp_t exp)
 {
     return miniexp_cadr(miniexp_cddr(exp));
@@ -478,36 +484,13 @@ QImage DjVuPage::render(qreal horizontalResolution, qreal verticalResolution, Ro
 {
     LOCK_PAGE
 
-    ddjvu_page_t* page = ddjvu_page_create_by_pageno(m_parent->m_document, m_index);
+    ddjvu_page_t* page = m_parent->decodedPage(m_index);
 
     if(page == 0)
     {
         return QImage();
     }
 
-    ddjvu_status_t status;
-
-    while(true)
-    {
-        status = ddjvu_page_decoding_status(page);
-
-        if(status < DDJVU_JOB_OK)
-        {
-            clearMessageQueue(m_parent->m_context, true);
-        }
-        else
-        {
-            break;
-        }
-    }
-
-    if(status >= DDJVU_JOB_FAILED)
-    {
-        ddjvu_page_release(page);
-
-        return QImage();
-    }
-
     switch(rotation)
     {
     default:
@@ -571,11 +554,49 @@ QImage DjVuPage::render(qreal horizontalResolution, qreal verticalResolution, Ro
 
     clearMessageQueue(m_parent->m_context, false);
 
-    ddjvu_page_release(page);
-
     return image;
 }
 
+QImage DjVuPage::thumbnail() const
+{
+    LOCK_PAGE
+
+    ddjvu_status_t status;
+
+    while(true)
+    {
+        status = ddjvu_thumbnail_status(m_parent->m_document, m_index, TRUE);
+
+        if(status < DDJVU_JOB_OK)
+        {
+            clearMessageQueue(m_parent->m_context, true);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if(status >= DDJVU_JOB_FAILED)
+    {
+        return QImage();
+    }
+
+    int w = maximumThumbnailExtent;
+    int h = maximumThumbnailExtent;
+
+    QImage image(w, h, QImage::Format_RGB32);
+
+    if(!ddjvu_thumbnail_render(m_parent->m_document, m_index, &w, &h, m_parent->m_format, image.bytesPerLine(), reinterpret_cast< char* >(image.bits())))
+    {
+        image = QImage();
+    }
+
+    clearMessageQueue(m_parent->m_context, false);
+
+    return image.isNull() ? image : image.copy(0, 0, w, h);
+}
+
 QList< Link* > DjVuPage::links() const
 {
     LOCK_PAGE
@@ -685,13 +706,15 @@ QList< QRectF > DjVuPage::search(const QString& text, bool matchCase) const
     return results;
 }
 
-DjVuDocument::DjVuDocument(QMutex* globalMutex, ddjvu_context_t* context, ddjvu_document_t* document) :
+DjVuDocument::DjVuDocument(QMutex* globalMutex, ddjvu_context_t* context, ddjvu_document_t* document, int maximumDecodedPages) :
     m_mutex(),
     m_globalMutex(globalMutex),
     m_context(context),
     m_document(document),
     m_format(0),
-    m_indexByName()
+    m_indexByName(),
+    m_decodedPages(),
+    m_maximumDecodedPages(qMax(maximumDecodedPages, 1))
 {
     unsigned int mask[] = {0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000};
 
@@ -704,6 +727,11 @@ DjVuDocument::DjVuDocument(QMutex* globalMutex, ddjvu_context_t* context, ddjvu_
 
 DjVuDocument::~DjVuDocument()
 {
+    foreach(const DecodedPage& decodedPage, m_decodedPages)
+    {
+        ddjvu_page_release(decodedPage.second);
+    }
+
     ddjvu_document_release(m_document);
     ddjvu_context_release(m_context);
     ddjvu_format_release(m_format);
@@ -788,6 +816,11 @@ bool DjVuDocument::save(const QString& filePath, bool withChanges) const
     return !ddjvu_job_error(job);
 }
 
+QByteArray DjVuDocument::renderKey() const
+{
+    return QByteArray("djvu");
+}
+
 void DjVuDocument::loadOutline(QStandardItemModel* outlineModel) const
 {
     Document::loadOutline(outlineModel);
@@ -878,12 +911,91 @@ void DjVuDocument::prepareIndexByName()
     }
 }
 
+ddjvu_page_t* DjVuDocument::decodedPage(int index) const
+{
+    for(int position = 0; position < m_decodedPages.count(); ++position)
+    {
+        if(m_decodedPages.at(position).first == index)
+        {
+            m_decodedPages.move(position, 0);
+
+            return m_decodedPages.first().second;
+        }
+    }
+
+    ddjvu_page_t* page = ddjvu_page_create_by_pageno(m_document, index);
+
+    if(page == 0)
+    {
+        return 0;
+    }
+
+    ddjvu_status_t status;
+
+    while(true)
+    {
+        status = ddjvu_page_decoding_status(page);
+
+        if(status < DDJVU_JOB_OK)
+        {
+            clearMessageQueue(m_context, true);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if(status >= DDJVU_JOB_FAILED)
+    {
+        ddjvu_page_release(page);
+
+        return 0;
+    }
+
+    m_decodedPages.prepend(qMakePair(index, page));
+
+    while(m_decodedPages.count() > m_maximumDecodedPages)
+    {
+        ddjvu_page_release(m_decodedPages.takeLast().second);
+    }
+
+    return page;
+}
+
 } // Model
 
+DjVuSettingsWidget::DjVuSettingsWidget(QSettings* settings, QWidget* parent) : SettingsWidget(parent),
+    m_settings(settings)
+{
+    m_layout = new QFormLayout(this);
+
+    // decoded pages
+
+    m_decodedPagesSpinBox = new QSpinBox(this);
+    m_decodedPagesSpinBox->setRange(1, 64);
+    m_decodedPagesSpinBox->setToolTip(tr("Decoded pages are kept in memory in addition to the pixmap cache."));
+    m_decodedPagesSpinBox->setValue(m_settings->value("decodedPages", defaultDecodedPages).toInt());
+
+    m_layout->addRow(tr("Decoded pages:"), m_decodedPagesSpinBox);
+}
+
+void DjVuSettingsWidget::accept()
+{
+    m_settings->setValue("decodedPages", m_decodedPagesSpinBox->value());
+}
+
+void DjVuSettingsWidget::reset()
+{
+    m_decodedPagesSpinBox->setValue(defaultDecodedPages);
+}
+
 DjVuPlugin::DjVuPlugin(QObject* parent) : QObject(parent),
     m_globalMutex()
 {
     setObjectName("DjVuPlugin");
+
+    m_settings = new QSettings("qpdfview", "djvu-plugin", this);
 }
 
 Model::Document* DjVuPlugin::loadDocument(const QString& filePath) const
@@ -922,7 +1034,13 @@ Model::Document* DjVuPlugin::loadDocument(const QString& filePath) const
         return 0;
     }
 
-    return new Model::DjVuDocument(&m_globalMutex, context, document);
+    return new Model::DjVuDocument(&m_globalMutex, context, document,
+                                   m_settings->value("decodedPages", defaultDecodedPages).toInt());
+}
+
+SettingsWidget* DjVuPlugin::createSettingsWidget(QWidget* parent) const
+{
+    return new DjVuSettingsWidget(m_settings, parent);
 }
 
 } // qpdfview
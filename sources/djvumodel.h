@@ -26,11 +26,18 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #define DJVUMODEL_H
 
 #include <QHash>
+#include <QList>
 #include <QMutex>
+#include <QPair>
+
+class QFormLayout;
+class QSettings;
+class QSpinBox;
 
 typedef struct ddjvu_context_s ddjvu_context_t;
 typedef struct ddjvu_format_s ddjvu_format_t;
 typedef struct ddjvu_document_s ddjvu_document_t;
+typedef struct ddjvu_page_s ddjvu_page_t;
 typedef struct ddjvu_pageinfo_s ddjvu_pageinfo_t;
 
 #include "model.h"
@@ -53,6 +60,8 @@ namespace Model
 
         QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, const QRect& boundingRect) const;
 
+        QImage thumbnail() const;
+
         QList< Link* > links() const;
 
         QString text(const QRectF& rect) const;
@@ -88,13 +97,15 @@ namespace Model
         bool canSave() const;
         bool save(const QString& filePath, bool withChanges) const;
 
+        QByteArray renderKey() const;
+
         void loadOutline(QStandardItemModel* outlineModel) const;
         void loadProperties(QStandardItemModel* propertiesModel) const;
 
     private:
         Q_DISABLE_COPY(DjVuDocument)
 
-        DjVuDocument(QMutex* globalMutex, ddjvu_context_t* context, ddjvu_document_t* document);
+        DjVuDocument(QMutex* globalMutex, ddjvu_context_t* context, ddjvu_document_t* document, int maximumDecodedPages);
 
         mutable QMutex m_mutex;
         mutable QMutex* m_globalMutex;
@@ -107,9 +118,38 @@ namespace Model
 
         void prepareIndexByName();
 
+        // decoded pages
+
+        typedef QPair< int, ddjvu_page_t* > DecodedPage;
+        mutable QList< DecodedPage > m_decodedPages;
+        int m_maximumDecodedPages;
+
+        ddjvu_page_t* decodedPage(int index) const;
+
     };
 }
 
+class DjVuSettingsWidget : public SettingsWidget
+{
+    Q_OBJECT
+
+public:
+    DjVuSettingsWidget(QSettings* settings, QWidget* parent = 0);
+
+    void accept();
+    void reset();
+
+private:
+    Q_DISABLE_COPY(DjVuSettingsWidget)
+
+    QSettings* m_settings;
+
+    QFormLayout* m_layout;
+
+    QSpinBox* m_decodedPagesSpinBox;
+
+};
+
 class DjVuPlugin : public QObject, Plugin
 {
     Q_OBJECT
@@ -126,9 +166,13 @@ public:
 
     Model::Document* loadDocument(const QString& filePath) const;
 
+    SettingsWidget* createSettingsWidget(QWidget* parent) const;
+
 private:
     mutable QMutex m_globalMutex;
 
+    QSettings* m_settings;
+
 };
 
 } // qpdfview
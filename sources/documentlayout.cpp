@@ -22,8 +22,9 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "documentlayout.h"
 
+#include <QRectF>
+
 #include "settings.h"
-#include "pageitem.h"
 
 namespace
 {
@@ -39,7 +40,14 @@ namespace qpdfview
 
 Settings* DocumentLayout::s_settings = 0;
 
-DocumentLayout::DocumentLayout()
+DocumentLayout::DocumentLayout() :
+    m_unitSizes(),
+    m_rightToLeft(false),
+    m_scale(1.0),
+    m_rowBegins(1, 0),
+    m_rowTops(1, 0.0),
+    m_leftExtents(),
+    m_rightExtents()
 {
     if(s_settings == 0)
     {
@@ -84,6 +92,168 @@ qreal DocumentLayout::visibleHeight(int viewportHeight) const
     return viewportHeight - 2.0f * pageSpacing;
 }
 
+void DocumentLayout::prepareLayout(const QVector< QSizeF >& unitSizes, bool rightToLeft)
+{
+    m_unitSizes = unitSizes;
+    m_rightToLeft = rightToLeft;
+
+    m_rowBegins.clear();
+    m_rowTops.clear();
+
+    const int count = m_unitSizes.count();
+    qreal top = 0.0;
+
+    for(int index = 0; index < count; index = rightIndex(index, count) + 1)
+    {
+        qreal rowHeight = 0.0;
+
+        for(int rowIndex = index; rowIndex <= rightIndex(index, count); ++rowIndex)
+        {
+            rowHeight = qMax(rowHeight, m_unitSizes.at(rowIndex).height());
+        }
+
+        m_rowBegins.append(index);
+        m_rowTops.append(top);
+
+        top += rowHeight;
+    }
+
+    m_rowBegins.append(count);
+    m_rowTops.append(top);
+
+    m_leftExtents.clear();
+    m_rightExtents.clear();
+
+    prepareExtents();
+}
+
+QRectF DocumentLayout::sceneRect() const
+{
+    const qreal pageSpacing = s_settings->documentView().pageSpacing();
+    const int rowCount = m_rowBegins.count() - 1;
+
+    const qreal left = -extent(m_leftExtents);
+    const qreal right = extent(m_rightExtents);
+    const qreal height = pageSpacing + m_scale * m_rowTops.last() + rowCount * pageSpacing;
+
+    return QRectF(left, 0.0, right - left, height);
+}
+
+QRectF DocumentLayout::rowRect(int index) const
+{
+    const int row = rowOf(index);
+
+    const qreal left = -extent(m_leftExtents);
+    const qreal right = extent(m_rightExtents);
+
+    return QRectF(left, rowTop(row), right - left, rowBottom(row) - rowTop(row));
+}
+
+QPointF DocumentLayout::pagePos(int index, const QRectF& boundingRect) const
+{
+    return QPointF(pageLeft(index, boundingRect.width()), rowTop(rowOf(index))) - boundingRect.topLeft();
+}
+
+QPair< int, int > DocumentLayout::visiblePages(qreal top, qreal bottom) const
+{
+    // Returns the first and last index of the pages in the rows overlapping the given vertical range which is empty if the first index exceeds the last one.
+    const int rowCount = m_rowBegins.count() - 1;
+
+    int firstRow = 0;
+
+    for(int end = rowCount; firstRow < end;)
+    {
+        const int row = (firstRow + end) / 2;
+
+        if(rowBottom(row) < top)
+        {
+            firstRow = row + 1;
+        }
+        else
+        {
+            end = row;
+        }
+    }
+
+    int lastRow = firstRow;
+
+    for(int end = rowCount; lastRow < end;)
+    {
+        const int row = (lastRow + end) / 2;
+
+        if(rowTop(row) <= bottom)
+        {
+            lastRow = row + 1;
+        }
+        else
+        {
+            end = row;
+        }
+    }
+
+    return qMakePair(m_rowBegins.at(firstRow), m_rowBegins.at(lastRow) - 1);
+}
+
+qreal DocumentLayout::rowsDistance(int index, int rows) const
+{
+    const int row = rowOf(index);
+    const int rowCount = m_rowBegins.count() - 1;
+
+    if(rows >= 0)
+    {
+        return rowBottom(qMin(row + rows, rowCount - 1)) - rowBottom(row);
+    }
+    else
+    {
+        return rowTop(row) - rowTop(qMax(row + rows, 0));
+    }
+}
+
+int DocumentLayout::rowOf(int index) const
+{
+    return qUpperBound(m_rowBegins.constBegin(), m_rowBegins.constEnd() - 1, index) - m_rowBegins.constBegin() - 1;
+}
+
+qreal DocumentLayout::rowTop(int row) const
+{
+    const qreal pageSpacing = s_settings->documentView().pageSpacing();
+
+    return pageSpacing + m_scale * m_rowTops.at(row) + row * pageSpacing;
+}
+
+qreal DocumentLayout::rowBottom(int row) const
+{
+    const qreal pageSpacing = s_settings->documentView().pageSpacing();
+
+    return pageSpacing + m_scale * m_rowTops.at(row + 1) + row * pageSpacing;
+}
+
+void DocumentLayout::addExtent(Extents& extents, qreal unit, qreal spacing)
+{
+    Extents::iterator iterator = extents.find(spacing);
+
+    if(iterator == extents.end())
+    {
+        extents.insert(spacing, unit);
+    }
+    else
+    {
+        iterator.value() = qMax(iterator.value(), unit);
+    }
+}
+
+qreal DocumentLayout::extent(const Extents& extents) const
+{
+    qreal extent = 0.0;
+
+    for(Extents::const_iterator iterator = extents.constBegin(); iterator != extents.constEnd(); ++iterator)
+    {
+        extent = qMax(extent, m_scale * iterator.value() + iterator.key());
+    }
+
+    return extent;
+}
+
 
 int SinglePageLayout::currentPage(int page) const
 {
@@ -127,27 +297,24 @@ qreal SinglePageLayout::visibleWidth(int viewportWidth) const
     return viewportWidth - viewportPadding - 2.0f * pageSpacing;
 }
 
-void SinglePageLayout::prepareLayout(const QVector< PageItem* >& pageItems, bool /* rightToLeft */,
-                                     qreal& left, qreal& right, qreal& height)
+void SinglePageLayout::prepareExtents()
 {
     const qreal pageSpacing = s_settings->documentView().pageSpacing();
-    qreal pageHeight = 0.0f;
 
-    for(int index = 0; index < pageItems.count(); ++index)
+    for(int index = 0; index < m_unitSizes.count(); ++index)
     {
-        PageItem* page = pageItems.at(index);
-        const QRectF boundingRect = page->boundingRect();
-
-        page->setPos(-boundingRect.left() - 0.5f * boundingRect.width(), height - boundingRect.top());
+        const qreal halfWidth = 0.5f * m_unitSizes.at(index).width();
 
-        pageHeight = boundingRect.height();
-
-        left = qMin(left, -0.5f * boundingRect.width() - pageSpacing);
-        right = qMax(right, 0.5f * boundingRect.width() + pageSpacing);
-        height += pageHeight + pageSpacing;
+        addExtent(m_leftExtents, halfWidth, pageSpacing);
+        addExtent(m_rightExtents, halfWidth, pageSpacing);
     }
 }
 
+qreal SinglePageLayout::pageLeft(int /* index */, qreal width) const
+{
+    return -0.5f * width;
+}
+
 
 int TwoPagesLayout::currentPage(int page) const
 {
@@ -189,58 +356,45 @@ qreal TwoPagesLayout::visibleWidth(int viewportWidth) const
     return (viewportWidth - viewportPadding - 3.0f * pageSpacing) / 2.0f;
 }
 
-void TwoPagesLayout::prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
-                                   qreal& left, qreal& right, qreal& height)
+void TwoPagesLayout::prepareExtents()
 {
     const qreal pageSpacing = s_settings->documentView().pageSpacing();
-    qreal pageHeight = 0.0f;
+    const int count = m_unitSizes.count();
 
-    for(int index = 0; index < pageItems.count(); ++index)
+    for(int index = 0; index < count; ++index)
     {
-        PageItem* page = pageItems.at(index);
-        const QRectF boundingRect = page->boundingRect();
-
-        const qreal leftPos = -boundingRect.left() - boundingRect.width() - 0.5f * pageSpacing;
-        const qreal rightPos = -boundingRect.left() + 0.5f * pageSpacing;
+        const qreal width = m_unitSizes.at(index).width();
 
         if(index == leftIndex(index))
         {
-            page->setPos(rightToLeft ? rightPos : leftPos, height - boundingRect.top());
-
-            pageHeight = boundingRect.height();
+            addExtent(m_rightToLeft ? m_rightExtents : m_leftExtents, width, 1.5f * pageSpacing);
 
-            if(rightToLeft)
+            if(index == rightIndex(index, count))
             {
-                right = qMax(right, boundingRect.width() + 1.5f * pageSpacing);
-            }
-            else
-            {
-                left = qMin(left, -boundingRect.width() - 1.5f * pageSpacing);
-            }
-
-            if(index == rightIndex(index, pageItems.count()))
-            {
-                right = qMax(right, 0.5f * pageSpacing);
-                height += pageHeight + pageSpacing;
+                addExtent(m_rightExtents, 0.0, 0.5f * pageSpacing);
             }
         }
         else
         {
-            page->setPos(rightToLeft ? leftPos : rightPos, height - boundingRect.top());
+            addExtent(m_rightToLeft ? m_leftExtents : m_rightExtents, width, 1.5f * pageSpacing);
+        }
+    }
+}
 
-            pageHeight = qMax(pageHeight, boundingRect.height());
+qreal TwoPagesLayout::pageLeft(int index, qreal width) const
+{
+    const qreal pageSpacing = s_settings->documentView().pageSpacing();
 
-            if(rightToLeft)
-            {
-                left = qMin(left, -boundingRect.width() - 1.5f * pageSpacing);
-            }
-            else
-            {
-                right = qMax(right, boundingRect.width() + 1.5f * pageSpacing);
-            }
+    const qreal leftPos = -width - 0.5f * pageSpacing;
+    const qreal rightPos = 0.5f * pageSpacing;
 
-            height += pageHeight + pageSpacing;
-        }
+    if(index == leftIndex(index))
+    {
+        return m_rightToLeft ? rightPos : leftPos;
+    }
+    else
+    {
+        return m_rightToLeft ? leftPos : rightPos;
     }
 }
 
@@ -313,50 +467,38 @@ qreal MultiplePagesLayout::visibleWidth(int viewportWidth) const
     return (viewportWidth - viewportPadding - (pagesPerRow + 1) * pageSpacing) / pagesPerRow;
 }
 
-void MultiplePagesLayout::prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
-                                        qreal& left, qreal& right, qreal& height)
+void MultiplePagesLayout::prepareExtents()
 {
     const qreal pageSpacing = s_settings->documentView().pageSpacing();
-    qreal pageHeight = 0.0;
+    const int count = m_unitSizes.count();
 
-    for(int index = 0; index < pageItems.count(); ++index)
+    for(int index = 0; index < count; index = rightIndex(index, count) + 1)
     {
-        PageItem* page = pageItems.at(index);
-        const QRectF boundingRect = page->boundingRect();
+        qreal rowWidth = 0.0;
 
-        const qreal leftPos = left - boundingRect.left() + pageSpacing;
-        const qreal rightPos = right - boundingRect.left() - boundingRect.width() - pageSpacing;
+        for(int rowIndex = index; rowIndex <= rightIndex(index, count); ++rowIndex)
+        {
+            rowWidth += m_unitSizes.at(rowIndex).width();
+        }
 
-        page->setPos(rightToLeft ? rightPos : leftPos, height - boundingRect.top());
+        const int pagesInRow = rightIndex(index, count) - index + 1;
 
-        pageHeight = qMax(pageHeight, boundingRect.height());
+        addExtent(m_rightToLeft ? m_leftExtents : m_rightExtents, rowWidth, (pagesInRow + 1) * pageSpacing);
+    }
+}
 
-        if(rightToLeft)
-        {
-            right -= boundingRect.width() + pageSpacing;
-        }
-        else
-        {
-            left += boundingRect.width() + pageSpacing;
-        }
+qreal MultiplePagesLayout::pageLeft(int index, qreal width) const
+{
+    const qreal pageSpacing = s_settings->documentView().pageSpacing();
 
-        if(index == rightIndex(index, pageItems.count()))
-        {
-            height += pageHeight + pageSpacing;
-            pageHeight = 0.0f;
+    qreal offset = pageSpacing;
 
-            if(rightToLeft)
-            {
-                left = qMin(left, right - pageSpacing);
-                right = 0.0f;
-            }
-            else
-            {
-                right = qMax(right, left + pageSpacing);
-                left = 0.0f;
-            }
-        }
+    for(int rowIndex = leftIndex(index); rowIndex < index; ++rowIndex)
+    {
+        offset += m_scale * m_unitSizes.at(rowIndex).width() + pageSpacing;
     }
+
+    return m_rightToLeft ? -offset - width : offset;
 }
 
 } // qpdfview
@@ -25,16 +25,18 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QMap>
 #include <QPair>
+#include <QSizeF>
+#include <QVector>
 
 #include "global.h"
 
+class QPointF;
 class QRectF;
 
 namespace qpdfview
 {
 
 class Settings;
-class PageItem;
 
 struct DocumentLayout
 {
@@ -59,12 +61,52 @@ struct DocumentLayout
     virtual qreal visibleWidth(int viewportWidth) const = 0;
     qreal visibleHeight(int viewportHeight) const;
 
-    virtual void prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
-                               qreal& left, qreal& right, qreal& height) = 0;
+    // the pages are laid out once at unit scale and then scaled as a whole so that zooming and resizing do not touch every page
+
+    void prepareLayout(const QVector< QSizeF >& unitSizes, bool rightToLeft);
+
+    inline qreal scale() const { return m_scale; }
+    inline void setScale(qreal scale) { m_scale = scale; }
+
+    QRectF sceneRect() const;
+    QRectF rowRect(int index) const;
+    QPointF pagePos(int index, const QRectF& boundingRect) const;
+
+    QPair< int, int > visiblePages(qreal top, qreal bottom) const;
+
+    // the scene distance covered by the given number of rows below, or above if negative, the row of the given page
+
+    qreal rowsDistance(int index, int rows) const;
 
 protected:
     static Settings* s_settings;
 
+    QVector< QSizeF > m_unitSizes;
+    bool m_rightToLeft;
+
+    qreal m_scale;
+
+    QVector< int > m_rowBegins;
+    QVector< qreal > m_rowTops;
+
+    int rowOf(int index) const;
+
+    qreal rowTop(int row) const;
+    qreal rowBottom(int row) const;
+
+    // the scene extends to the maximum of unit times scale plus spacing over these entries which are keyed by spacing
+
+    typedef QMap< qreal, qreal > Extents;
+
+    Extents m_leftExtents;
+    Extents m_rightExtents;
+
+    static void addExtent(Extents& extents, qreal unit, qreal spacing);
+    qreal extent(const Extents& extents) const;
+
+    virtual void prepareExtents() = 0;
+    virtual qreal pageLeft(int index, qreal width) const = 0;
+
 };
 
 struct SinglePageLayout : public DocumentLayout
@@ -82,8 +124,9 @@ struct SinglePageLayout : public DocumentLayout
 
     qreal visibleWidth(int viewportWidth) const;
 
-    void prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
-                       qreal& left, qreal& right, qreal& height);
+protected:
+    void prepareExtents();
+    qreal pageLeft(int index, qreal width) const;
 
 };
 
@@ -102,8 +145,9 @@ struct TwoPagesLayout : public DocumentLayout
 
     qreal visibleWidth(int viewportWidth) const;
 
-    void prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
-                       qreal& left, qreal& right, qreal& height);
+protected:
+    void prepareExtents();
+    qreal pageLeft(int index, qreal width) const;
 
 };
 
@@ -133,8 +177,9 @@ struct MultiplePagesLayout : public DocumentLayout
 
     qreal visibleWidth(int viewportWidth) const;
 
-    void prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
-                       qreal& left, qreal& right, qreal& height);
+protected:
+    void prepareExtents();
+    qreal pageLeft(int index, qreal width) const;
 
 };
 
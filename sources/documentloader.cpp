@@ -0,0 +1,231 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "documentloader.h"
+
+#include <QDebug>
+
+#include "model.h"
+
+namespace
+{
+
+// pages are handed over in batches so that the view is not laid out again for every single page
+
+const int pagesPerBatch = 64;
+
+enum
+{
+    NotCanceled = 0,
+    Canceled = 1
+};
+
+void setCancellation(QAtomicInt& wasCanceled)
+{
+#if QT_VERSION > QT_VERSION_CHECK(5,0,0)
+
+    wasCanceled.storeRelease(Canceled);
+
+#else
+
+    wasCanceled.fetchAndStoreRelease(Canceled);
+
+#endif // QT_VERSION
+}
+
+void resetCancellation(QAtomicInt& wasCanceled)
+{
+#if QT_VERSION > QT_VERSION_CHECK(5,0,0)
+
+    wasCanceled.storeRelease(NotCanceled);
+
+#else
+
+    wasCanceled.fetchAndStoreRelease(NotCanceled);
+
+#endif // QT_VERSION
+}
+
+bool testCancellation(QAtomicInt& wasCanceled)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+
+    return wasCanceled.load() != NotCanceled;
+
+#else
+
+    return !wasCanceled.testAndSetRelaxed(NotCanceled, NotCanceled);
+
+#endif // QT_VERSION
+}
+
+int loadWasCanceled(const QAtomicInt& wasCanceled)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+
+    return wasCanceled.load();
+
+#else
+
+    return wasCanceled;
+
+#endif // QT_VERSION
+}
+
+} // anonymous
+
+namespace qpdfview
+{
+
+QMutex DocumentLoader::s_pluginMutex;
+
+DocumentLoader::DocumentLoader(QObject* parent) : QThread(parent),
+    m_wasCanceled(NotCanceled),
+    m_plugin(0),
+    m_filePath(),
+    m_document(0),
+    m_beginAtIndex(0),
+    m_mutex(),
+    m_pages(),
+    m_failedIndex(-1)
+{
+}
+
+bool DocumentLoader::wasCanceled() const
+{
+    return loadWasCanceled(m_wasCanceled) != NotCanceled;
+}
+
+Model::Document* DocumentLoader::takeDocument()
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    Model::Document* document = m_document;
+    m_document = 0;
+
+    return document;
+}
+
+QVector< Model::Page* > DocumentLoader::takePages()
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    QVector< Model::Page* > pages;
+    pages.swap(m_pages);
+
+    return pages;
+}
+
+int DocumentLoader::failedIndex() const
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    return m_failedIndex;
+}
+
+void DocumentLoader::run()
+{
+    if(m_plugin != 0)
+    {
+        // several views might be opening documents, but the plug-ins are not expected to load them concurrently
+
+        s_pluginMutex.lock();
+        Model::Document* document = m_plugin->loadDocument(m_filePath);
+        s_pluginMutex.unlock();
+
+        m_mutex.lock();
+        m_document = document;
+        m_mutex.unlock();
+
+        emit documentLoaded();
+
+        return;
+    }
+
+    const int numberOfPages = m_document->numberOfPages();
+
+    for(int index = m_beginAtIndex; index < numberOfPages; ++index)
+    {
+        if(testCancellation(m_wasCanceled))
+        {
+            return;
+        }
+
+        Model::Page* page = m_document->page(index);
+
+        if(page == 0)
+        {
+            qWarning() << "No page" << index << "was found in document.";
+
+            m_mutex.lock();
+            m_failedIndex = index;
+            m_mutex.unlock();
+
+            return;
+        }
+
+        QMutexLocker mutexLocker(&m_mutex);
+
+        m_pages.append(page);
+
+        if(m_pages.count() % pagesPerBatch == 0)
+        {
+            mutexLocker.unlock();
+
+            emit pagesLoaded();
+        }
+    }
+}
+
+void DocumentLoader::load(Plugin* plugin, const QString& filePath)
+{
+    m_plugin = plugin;
+    m_filePath = filePath;
+
+    m_document = 0;
+    m_failedIndex = -1;
+
+    resetCancellation(m_wasCanceled);
+
+    QThread::start();
+}
+
+void DocumentLoader::start(Model::Document* document, int beginAtIndex)
+{
+    m_plugin = 0;
+    m_filePath.clear();
+
+    m_document = document;
+    m_beginAtIndex = beginAtIndex;
+    m_failedIndex = -1;
+
+    resetCancellation(m_wasCanceled);
+
+    QThread::start();
+}
+
+void DocumentLoader::cancel()
+{
+    setCancellation(m_wasCanceled);
+}
+
+} // qpdfview
@@ -0,0 +1,89 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef DOCUMENTLOADER_H
+#define DOCUMENTLOADER_H
+
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QVector>
+
+namespace qpdfview
+{
+
+namespace Model
+{
+class Document;
+class Page;
+}
+
+class Plugin;
+
+class DocumentLoader : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit DocumentLoader(QObject* parent = 0);
+
+    bool wasCanceled() const;
+
+    Model::Document* takeDocument();
+    QVector< Model::Page* > takePages();
+
+    int failedIndex() const;
+
+    void run();
+
+signals:
+    void documentLoaded();
+    void pagesLoaded();
+
+public slots:
+    void load(Plugin* plugin, const QString& filePath);
+    void start(Model::Document* document, int beginAtIndex);
+
+    void cancel();
+
+private:
+    Q_DISABLE_COPY(DocumentLoader)
+
+    static QMutex s_pluginMutex;
+
+    QAtomicInt m_wasCanceled;
+
+    Plugin* m_plugin;
+    QString m_filePath;
+
+    Model::Document* m_document;
+    int m_beginAtIndex;
+
+    mutable QMutex m_mutex;
+    QVector< Model::Page* > m_pages;
+    int m_failedIndex;
+
+};
+
+} // qpdfview
+
+#endif // DOCUMENTLOADER_H
@@ -26,12 +26,15 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QApplication>
 #include <QInputDialog>
+#include <QDateTime>
 #include <QDebug>
 #include <QDesktopWidget>
 #include <QDesktopServices>
 #include <QDir>
+#include <QEventLoop>
 #include <QFileSystemWatcher>
 #include <QKeyEvent>
+#include <QLabel>
 #include <qmath.h>
 #include <QMenu>
 #include <QMessageBox>
@@ -65,6 +68,14 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include "presentationview.h"
 #include "searchmodel.h"
 #include "searchtask.h"
+#include "documentloader.h"
+#include "searchindex.h"
+#include "database.h"
+#include "renderscheduler.h"
+#include "diskcache.h"
+#include "memorymanager.h"
+#include "renderstatistics.h"
+#include "tileitem.h"
 #include "miscellaneous.h"
 #include "documentlayout.h"
 #include "mainwindow.h"
@@ -225,6 +236,45 @@ inline QRectF rectOfResult(const QModelIndex& index)
     return index.data(SearchModel::RectRole).toRectF();
 }
 
+// scroll velocities are measured in scene units per millisecond
+
+const qint64 scrollVelocityTimeout = 500;
+const qreal minimumScrollVelocity = 0.5;
+
+const qreal prefetchLookahead = 1000.0;
+
+// the first pages are loaded right away and the remaining ones are appended while the user already reads
+
+const int initiallyLoadedPages = 16;
+
+inline qreal currentScrollVelocity(const QElapsedTimer& scrollTimer, qreal scrollVelocity)
+{
+    return scrollTimer.isValid() && scrollTimer.elapsed() < scrollVelocityTimeout ? scrollVelocity : 0.0;
+}
+
+inline int estimatedCost(const PageItem* page)
+{
+    const QSizeF size = page->boundingRect().size() * page->devicePixelRatio();
+
+    return qCeil(size.width()) * qCeil(size.height()) * 4;
+}
+
+bool prefetchPage(PageItem* page, int& budget)
+{
+    const int cost = estimatedCost(page);
+
+    if(cost > budget)
+    {
+        return false;
+    }
+
+    budget -= cost;
+
+    page->startRender(true);
+
+    return true;
+}
+
 } // anonymous
 
 namespace qpdfview
@@ -238,6 +288,13 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
     m_autoRefreshWatcher(0),
     m_autoRefreshTimer(0),
     m_prefetchTimer(0),
+    m_scrollTimer(),
+    m_scrollValue(0),
+    m_scrollVelocity(0.0),
+    m_renderScheduler(0),
+    m_thumbnailsRenderScheduler(0),
+    m_renderStatisticsLabel(0),
+    m_renderStatisticsTimer(0),
     m_document(0),
     m_pages(),
     m_fileInfo(),
@@ -246,6 +303,7 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
     m_firstPage(-1),
     m_past(),
     m_future(),
+    m_pendingJump(),
     m_layout(new SinglePageLayout),
     m_continuousMode(false),
     m_scaleMode(ScaleFactorMode),
@@ -257,13 +315,30 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
     m_rubberBandMode(ModifiersMode),
     m_pageItems(),
     m_thumbnailItems(),
+    m_visiblePages(0, -1),
+    m_retainedPages(0, -1),
+    m_prefetchedPages(0, -1),
+    m_layoutIsPrepared(false),
+    m_preparedPages(),
+    m_highlightedThumbnail(-1),
     m_highlight(0),
     m_thumbnailsOrientation(Qt::Vertical),
     m_thumbnailsScene(0),
+    m_thumbnailsIndices(),
+    m_thumbnailsBegins(),
+    m_thumbnailsEnds(),
+    m_visibleThumbnails(0, -1),
+    m_thumbnailsViewport(),
+    m_preparedThumbnails(),
     m_outlineModel(0),
     m_propertiesModel(0),
+    m_documentLoader(0),
+    m_documentIsOpening(false),
+    m_documentIsLoading(false),
+    m_loadingLabel(0),
     m_currentResult(),
-    m_searchTask(0)
+    m_searchTask(0),
+    m_searchIndex(0)
 {
     if(s_settings == 0)
     {
@@ -286,6 +361,7 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
     setDragMode(QGraphicsView::ScrollHandDrag);
 
     connect(verticalScrollBar(), SIGNAL(valueChanged(int)), SLOT(on_verticalScrollBar_valueChanged()));
+    connect(horizontalScrollBar(), SIGNAL(valueChanged(int)), SLOT(on_horizontalScrollBar_valueChanged()));
 
     m_thumbnailsScene = new QGraphicsScene(this);
 
@@ -309,6 +385,26 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
     connect(m_searchTask, SIGNAL(progressChanged(int)), SLOT(on_searchTask_progressChanged(int)));
     connect(m_searchTask, SIGNAL(resultsReady(int,QList<QRectF>)), SLOT(on_searchTask_resultsReady(int,QList<QRectF>)));
 
+    m_searchIndex = new SearchIndex(this);
+
+    connect(m_searchIndex, SIGNAL(finished()), SLOT(on_searchIndex_finished()));
+
+    // document loader
+
+    m_documentLoader = new DocumentLoader(this);
+
+    connect(m_documentLoader, SIGNAL(pagesLoaded()), SLOT(on_documentLoader_pagesLoaded()));
+    connect(m_documentLoader, SIGNAL(finished()), SLOT(on_documentLoader_finished()));
+
+    // the remaining pages are loaded in the background and only indicated next to the document
+
+    m_loadingLabel = new QLabel(this);
+    m_loadingLabel->setAutoFillBackground(true);
+    m_loadingLabel->setBackgroundRole(QPalette::ToolTipBase);
+    m_loadingLabel->setForegroundRole(QPalette::ToolTipText);
+    m_loadingLabel->setMargin(5);
+    m_loadingLabel->setVisible(false);
+
     // auto-refresh
 
     m_autoRefreshWatcher = new QFileSystemWatcher(this);
@@ -327,7 +423,7 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
     m_prefetchTimer->setInterval(s_settings->documentView().prefetchTimeout());
     m_prefetchTimer->setSingleShot(true);
 
-    connect(this, SIGNAL(currentPageChanged(int)), m_prefetchTimer, SLOT(start()));
+    connect(this, SIGNAL(currentPageChanged(int)), SLOT(on_prefetch_requested()));
     connect(this, SIGNAL(layoutModeChanged(LayoutMode)), m_prefetchTimer, SLOT(start()));
     connect(this, SIGNAL(scaleModeChanged(ScaleMode)), m_prefetchTimer, SLOT(start()));
     connect(this, SIGNAL(scaleFactorChanged(qreal)), m_prefetchTimer, SLOT(start()));
@@ -336,6 +432,38 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
 
     connect(m_prefetchTimer, SIGNAL(timeout()), SLOT(on_prefetch_timeout()));
 
+    // render scheduler
+
+    m_renderScheduler = new RenderScheduler(this);
+
+    // thumbnails only render on a single thread whenever no visible tiles are pending
+
+    m_thumbnailsRenderScheduler = new RenderScheduler(this);
+    m_thumbnailsRenderScheduler->setSuperior(m_renderScheduler);
+    m_thumbnailsRenderScheduler->setMaximumThreadCount(1);
+
+    // render statistics
+
+    // the label is not a child of the viewport which would scroll it away with the scene
+
+    m_renderStatisticsLabel = new QLabel(this);
+    m_renderStatisticsLabel->setAutoFillBackground(true);
+    m_renderStatisticsLabel->setBackgroundRole(QPalette::ToolTipBase);
+    m_renderStatisticsLabel->setForegroundRole(QPalette::ToolTipText);
+    m_renderStatisticsLabel->setMargin(5);
+    m_renderStatisticsLabel->setVisible(false);
+
+    m_renderStatisticsTimer = new QTimer(this);
+    m_renderStatisticsTimer->setInterval(1000);
+
+    connect(m_renderStatisticsTimer, SIGNAL(timeout()), SLOT(on_renderStatistics_timeout()));
+
+    // memory manager
+
+    connect(MemoryManager::instance(), SIGNAL(budgetsChanged()), SLOT(on_memoryManager_budgetsChanged()));
+
+    MemoryManager::instance()->registerView();
+
     // settings
 
     m_continuousMode = s_settings->documentView().continuousMode();
@@ -353,16 +481,24 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
 
 DocumentView::~DocumentView()
 {
+    cancelLoading();
+
     m_searchTask->cancel();
     m_searchTask->wait();
 
+    m_searchIndex->clear();
+
     s_searchModel->clearResults(this);
 
     qDeleteAll(m_pageItems);
     qDeleteAll(m_thumbnailItems);
 
+    delete m_thumbnailsRenderScheduler;
+
     qDeleteAll(m_pages);
     delete m_document;
+
+    MemoryManager::instance()->unregisterView();
 }
 
 void DocumentView::setFirstPage(int firstPage)
@@ -560,6 +696,7 @@ void DocumentView::setLayoutMode(LayoutMode layoutMode)
     if(m_layout->layoutMode() != layoutMode && layoutMode >= 0 && layoutMode < NumberOfLayoutModes)
     {
         m_layout.reset(DocumentLayout::fromLayoutMode(layoutMode));
+        m_layoutIsPrepared = false;
 
         if(m_currentPage != m_layout->currentPage(m_currentPage))
         {
@@ -582,6 +719,7 @@ void DocumentView::setRightToLeftMode(bool rightToLeftMode)
     if(m_rightToLeftMode != rightToLeftMode)
     {
         m_rightToLeftMode = rightToLeftMode;
+        m_layoutIsPrepared = false;
 
         prepareScene();
         prepareView();
@@ -597,6 +735,7 @@ void DocumentView::setScaleMode(ScaleMode scaleMode)
     if(m_scaleMode != scaleMode && scaleMode >= 0 && scaleMode < NumberOfScaleModes)
     {
         m_scaleMode = scaleMode;
+        m_layoutIsPrepared = false;
 
         qreal left = 0.0, top = 0.0;
         saveLeftAndTop(left, top);
@@ -640,6 +779,7 @@ void DocumentView::setRotation(Rotation rotation)
     if(m_rotation != rotation && rotation >= 0 && rotation < NumberOfRotations)
     {
         m_rotation = rotation;
+        m_layoutIsPrepared = false;
 
         prepareScene();
         prepareView();
@@ -747,6 +887,11 @@ bool DocumentView::searchWasCanceled() const
     return m_searchTask->wasCanceled();
 }
 
+bool DocumentView::searchIsRunning() const
+{
+    return m_searchTask->isRunning();
+}
+
 int DocumentView::searchProgress() const
 {
     return m_searchTask->progress();
@@ -762,6 +907,66 @@ void DocumentView::setThumbnailsOrientation(Qt::Orientation thumbnailsOrientatio
     }
 }
 
+void DocumentView::setThumbnailsViewport(const QRectF& thumbnailsViewport)
+{
+    m_thumbnailsViewport = thumbnailsViewport;
+
+    m_thumbnailsRenderScheduler->setViewport(thumbnailsViewport);
+
+    // the thumbnails are found by bisecting the layout so that scrolling does not scan the whole strip
+
+    const qreal begin = m_thumbnailsOrientation == Qt::Vertical ? thumbnailsViewport.top() : thumbnailsViewport.left();
+    const qreal end = m_thumbnailsOrientation == Qt::Vertical ? thumbnailsViewport.bottom() : thumbnailsViewport.right();
+
+    const int first = qLowerBound(m_thumbnailsEnds.constBegin(), m_thumbnailsEnds.constEnd(), begin) - m_thumbnailsEnds.constBegin();
+    const int last = qUpperBound(m_thumbnailsBegins.constBegin(), m_thumbnailsBegins.constEnd(), end) - m_thumbnailsBegins.constBegin() - 1;
+
+    for(int position = m_visibleThumbnails.first; position <= m_visibleThumbnails.second; ++position)
+    {
+        if(position < first || position > last)
+        {
+            m_thumbnailItems.at(m_thumbnailsIndices.at(position))->cancelRender();
+        }
+    }
+
+    m_visibleThumbnails = qMakePair(first, last);
+
+    // thumbnails within a viewport's length are prepared and those further away are released, except for the current one
+
+    const qreal length = end - begin;
+
+    const int nearFirst = qLowerBound(m_thumbnailsEnds.constBegin(), m_thumbnailsEnds.constEnd(), begin - length) - m_thumbnailsEnds.constBegin();
+    const int nearLast = qUpperBound(m_thumbnailsBegins.constBegin(), m_thumbnailsBegins.constEnd(), end + length) - m_thumbnailsBegins.constBegin() - 1;
+
+    const int firstIndex = nearFirst <= nearLast ? m_thumbnailsIndices.at(nearFirst) : 0;
+    const int lastIndex = nearFirst <= nearLast ? m_thumbnailsIndices.at(nearLast) : -1;
+
+    for(QSet< int >::iterator iterator = m_preparedThumbnails.begin(); iterator != m_preparedThumbnails.end();)
+    {
+        const int index = *iterator;
+
+        if((index < firstIndex || index > lastIndex) && index != m_currentPage - 1)
+        {
+            ThumbnailItem* page = m_thumbnailItems.at(index);
+
+            page->setVisible(false);
+
+            page->cancelRender();
+
+            iterator = m_preparedThumbnails.erase(iterator);
+        }
+        else
+        {
+            ++iterator;
+        }
+    }
+
+    for(int position = nearFirst; position <= nearLast; ++position)
+    {
+        prepareThumbnailItem(position);
+    }
+}
+
 QStandardItemModel* DocumentView::fontsModel() const
 {
     QStandardItemModel* fontsModel = new QStandardItemModel();
@@ -807,20 +1012,11 @@ void DocumentView::show()
 
 bool DocumentView::open(const QString& filePath)
 {
-    Model::Document* document = PluginHandler::instance()->loadDocument(filePath);
+    QVector< Model::Page* > pages;
+    Model::Document* document = loadDocument(filePath, pages);
 
     if(document != 0)
     {
-        QVector< Model::Page* > pages;
-
-        if(!checkDocument(filePath, document, pages))
-        {
-            delete document;
-            qDeleteAll(pages);
-
-            return false;
-        }
-
         m_fileInfo.setFile(filePath);
         m_wasModified = false;
 
@@ -857,20 +1053,11 @@ bool DocumentView::open(const QString& filePath)
 
 bool DocumentView::refresh()
 {
-    Model::Document* document = PluginHandler::instance()->loadDocument(m_fileInfo.filePath());
+    QVector< Model::Page* > pages;
+    Model::Document* document = loadDocument(m_fileInfo.filePath(), pages);
 
     if(document != 0)
     {
-        QVector< Model::Page* > pages;
-
-        if(!checkDocument(m_fileInfo.filePath(), document, pages))
-        {
-            delete document;
-            qDeleteAll(pages);
-
-            return false;
-        }
-
         MainWindow::instance()->m_outlineView->saveExpansionState(m_outlineModel->invisibleRootItem()->index());
 
         qreal left = 0.0, top = 0.0;
@@ -878,13 +1065,22 @@ bool DocumentView::refresh()
 
         m_wasModified = false;
 
-        m_currentPage = qMin(m_currentPage, document->numberOfPages());
+        const int currentPage = qMin(m_currentPage, document->numberOfPages());
+
+        m_currentPage = qMin(currentPage, pages.count());
 
         prepareDocument(document, pages);
 
         prepareScene();
         prepareView(left, top);
 
+        // return to the current page once it was loaded
+
+        if(currentPage > m_pages.count())
+        {
+            m_pendingJump = Position(currentPage, left, top);
+        }
+
         prepareThumbnailsScene();
 
         emit documentChanged();
@@ -983,8 +1179,17 @@ void DocumentView::lastPage()
 
 void DocumentView::jumpToPage(int page, bool trackChange, qreal changeLeft, qreal changeTop)
 {
+    if(m_documentIsLoading && page > m_pages.count() && page <= m_document->numberOfPages())
+    {
+        m_pendingJump = Position(page, changeLeft, changeTop);
+
+        return;
+    }
+
     if(page >= 1 && page <= m_pages.count())
     {
+        m_pendingJump = Position();
+
         qreal left = 0.0, top = 0.0;
         saveLeftAndTop(left, top);
 
@@ -1064,7 +1269,7 @@ void DocumentView::startSearch(const QString& text, bool matchCase)
     cancelSearch();
     clearResults();
 
-    m_searchTask->start(m_pages, text, matchCase, m_currentPage);
+    m_searchTask->start(m_pages, text, matchCase, m_currentPage, m_searchIndex);
 }
 
 void DocumentView::cancelSearch()
@@ -1132,6 +1337,8 @@ void DocumentView::zoomIn()
 {
     if(scaleMode() != ScaleFactorMode)
     {
+        preparePageItem(m_currentPage - 1);
+
         setScaleFactor(qMin(m_pageItems.at(m_currentPage - 1)->scaleFactor() * s_settings->documentView().zoomFactor(),
                             s_settings->documentView().maximumScaleFactor()));
 
@@ -1148,6 +1355,8 @@ void DocumentView::zoomOut()
 {
     if(scaleMode() != ScaleFactorMode)
     {
+        preparePageItem(m_currentPage - 1);
+
         setScaleFactor(qMax(m_pageItems.at(m_currentPage - 1)->scaleFactor() / s_settings->documentView().zoomFactor(),
                             s_settings->documentView().minimumScaleFactor()));
 
@@ -1234,17 +1443,103 @@ void DocumentView::startPresentation()
 
 void DocumentView::on_verticalScrollBar_valueChanged()
 {
+    const QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
+
+    m_renderScheduler->setViewport(visibleRect);
+
+    // the scroll velocity is smoothed over recent changes and forgotten after a pause
+
+    const int scrollValue = verticalScrollBar()->value();
+
+    if(m_scrollTimer.isValid() && m_scrollTimer.elapsed() < scrollVelocityTimeout)
+    {
+        const qreal velocity = (scrollValue - m_scrollValue) / qMax(qreal(m_scrollTimer.elapsed()), qreal(1.0));
+
+        m_scrollVelocity = 0.5 * m_scrollVelocity + 0.5 * velocity;
+    }
+    else
+    {
+        m_scrollVelocity = 0.0;
+    }
+
+    m_scrollTimer.start();
+    m_scrollValue = scrollValue;
+
+    // interactive elements are loaded for pages near the viewport and dropped for pages far away from it
+
+    const QPair< int, int > nearbyPages = m_layout->visiblePages(visibleRect.top() - visibleRect.height(), visibleRect.bottom() + visibleRect.height());
+    const QPair< int, int > retainedPages = m_layout->visiblePages(visibleRect.top() - 4.0 * visibleRect.height(), visibleRect.bottom() + 4.0 * visibleRect.height());
+
+    for(int index = m_retainedPages.first; index <= m_retainedPages.second; ++index)
+    {
+        if(index < retainedPages.first || index > retainedPages.second)
+        {
+            m_pageItems.at(index)->dropInteractiveElements();
+        }
+    }
+
+    m_retainedPages = retainedPages;
+
+    // pages far away from the viewport are released so that relayouting only touches pages near it
+
+    for(QSet< int >::iterator iterator = m_preparedPages.begin(); iterator != m_preparedPages.end();)
+    {
+        const int index = *iterator;
+
+        if((index < retainedPages.first || index > retainedPages.second)
+                && (index < m_prefetchedPages.first || index > m_prefetchedPages.second)
+                && index != m_currentPage - 1)
+        {
+            PageItem* page = m_pageItems.at(index);
+
+            page->setVisible(false);
+
+            page->cancelRender();
+
+            iterator = m_preparedPages.erase(iterator);
+        }
+        else
+        {
+            ++iterator;
+        }
+    }
+
+    for(int index = nearbyPages.first; index <= nearbyPages.second; ++index)
+    {
+        preparePageItem(index);
+
+        if(m_pageItems.at(index)->isVisible())
+        {
+            m_pageItems.at(index)->prepareInteractiveElements();
+        }
+    }
+
     if(!m_continuousMode)
     {
         return;
     }
 
+    // only pages which left the viewport need to be canceled
+
+    const QPair< int, int > visiblePages = m_layout->visiblePages(visibleRect.top(), visibleRect.bottom());
+
+    for(int index = m_visiblePages.first; index <= m_visiblePages.second; ++index)
+    {
+        if(index < visiblePages.first || index > visiblePages.second)
+        {
+            m_pageItems.at(index)->cancelRender();
+        }
+    }
+
+    m_visiblePages = visiblePages;
+
     int currentPage = -1;
-    const QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
 
-    foreach(PageItem* page, m_pageItems)
+    for(int index = visiblePages.first; index <= visiblePages.second; ++index)
     {
-        const int pageNumber = page->index() + 1;
+        PageItem* page = m_pageItems.at(index);
+
+        const int pageNumber = index + 1;
         const QRectF pageRect = page->boundingRect().translated(page->pos());
 
         if(!pageRect.intersects(visibleRect))
@@ -1265,16 +1560,15 @@ void DocumentView::on_verticalScrollBar_valueChanged()
 
         emit currentPageChanged(m_currentPage);
 
-        if(s_settings->documentView().highlightCurrentThumbnail())
-        {
-            for(int index = 0; index < m_thumbnailItems.count(); ++index)
-            {
-                m_thumbnailItems.at(index)->setHighlighted(index == m_currentPage - 1);
-            }
-        }
+        prepareCurrentThumbnail();
     }
 }
 
+void DocumentView::on_horizontalScrollBar_valueChanged()
+{
+    m_renderScheduler->setViewport(mapToScene(viewport()->rect()).boundingRect());
+}
+
 void DocumentView::on_autoRefresh_timeout()
 {
     if(m_fileInfo.exists())
@@ -1291,32 +1585,139 @@ void DocumentView::on_autoRefresh_timeout()
 
 void DocumentView::on_prefetch_timeout()
 {
-    const QPair< int, int > prefetchRange = m_layout->prefetchRange(m_currentPage, m_pages.count());
+    const qreal scrollVelocity = currentScrollVelocity(m_scrollTimer, m_scrollVelocity);
+
+    // the prefetched pixmaps should leave room in the cache for the visible pages
+
+    const int tileBudget = MemoryManager::instance()->tileBudget();
+
+    int budget = tileBudget;
 
-    const int maxCost = prefetchRange.second - prefetchRange.first + 1;
-    int cost = 0;
+    for(int index = m_visiblePages.first; index <= m_visiblePages.second; ++index)
+    {
+        budget -= estimatedCost(m_pageItems.at(index));
+    }
 
-    for(int index = m_currentPage - 1; index <= prefetchRange.second - 1; ++index)
+    budget = qMax(budget, tileBudget / 4);
+
+    if(!m_continuousMode || qAbs(scrollVelocity) < minimumScrollVelocity)
     {
-        cost += m_pageItems.at(index)->startRender(true);
+        const QPair< int, int > prefetchRange = m_layout->prefetchRange(m_currentPage, m_pages.count());
+
+        m_prefetchedPages = qMakePair(prefetchRange.first - 1, prefetchRange.second - 1);
 
-        if(cost >= maxCost)
+        for(int index = m_currentPage - 1; index <= prefetchRange.second - 1; ++index)
         {
-            return;
+            preparePageItem(index);
+
+            if(!prefetchPage(m_pageItems.at(index), budget))
+            {
+                return;
+            }
+        }
+
+        for(int index = m_currentPage - 2; index >= prefetchRange.first - 1; --index)
+        {
+            preparePageItem(index);
+
+            if(!prefetchPage(m_pageItems.at(index), budget))
+            {
+                return;
+            }
         }
+
+        return;
     }
 
-    for(int index = m_currentPage - 1; index >= prefetchRange.first - 1; --index)
+    // while scrolling, only pages ahead of the viewport are prefetched and the distance,
+    // which is given in rows as when idle, is extended according to the scroll velocity
+
+    const QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
+    const QPair< int, int > visiblePages = m_layout->visiblePages(visibleRect.top(), visibleRect.bottom());
+
+    const bool forward = scrollVelocity > 0.0;
+
+    const int prefetchDistance = s_settings->documentView().prefetchDistance();
+
+    qreal distance = qAbs(scrollVelocity) * prefetchLookahead;
+
+    if(visiblePages.first <= visiblePages.second)
     {
-        cost += m_pageItems.at(index)->startRender(true);
+        distance += forward
+                ? m_layout->rowsDistance(visiblePages.second, prefetchDistance)
+                : m_layout->rowsDistance(visiblePages.first, -prefetchDistance);
+    }
+
+    const QPair< int, int > prefetchedPages = forward
+            ? m_layout->visiblePages(visibleRect.top(), visibleRect.bottom() + distance)
+            : m_layout->visiblePages(visibleRect.top() - distance, visibleRect.bottom());
 
-        if(cost >= maxCost)
+    // pages which the user has already passed are not prefetched any longer,
+    // which needs a forcible cancellation as prefetches ignore the normal one
+
+    for(int index = m_prefetchedPages.first; index <= m_prefetchedPages.second; ++index)
+    {
+        if(index < prefetchedPages.first || index > prefetchedPages.second)
         {
-            return;
+            m_pageItems.at(index)->cancelRender(true);
+        }
+    }
+
+    m_prefetchedPages = prefetchedPages;
+
+    if(forward)
+    {
+        for(int index = prefetchedPages.first; index <= prefetchedPages.second; ++index)
+        {
+            preparePageItem(index);
+
+            if(!prefetchPage(m_pageItems.at(index), budget))
+            {
+                return;
+            }
+        }
+    }
+    else
+    {
+        for(int index = prefetchedPages.second; index >= prefetchedPages.first; --index)
+        {
+            preparePageItem(index);
+
+            if(!prefetchPage(m_pageItems.at(index), budget))
+            {
+                return;
+            }
         }
     }
 }
 
+void DocumentView::on_prefetch_requested()
+{
+    // while scrolling, a pending prefetch is not postponed so that it keeps up with the motion
+
+    if(m_prefetchTimer->isActive() && qAbs(currentScrollVelocity(m_scrollTimer, m_scrollVelocity)) >= minimumScrollVelocity)
+    {
+        return;
+    }
+
+    m_prefetchTimer->start();
+}
+
+void DocumentView::on_memoryManager_budgetsChanged()
+{
+    TileItem::updateCacheBudgets();
+}
+
+void DocumentView::on_renderStatistics_timeout()
+{
+    m_renderStatisticsLabel->setText(tr("Queue depth: %1").arg(m_renderScheduler->queueDepth()) + QLatin1Char('\n')
+                                     + RenderStatistics::instance()->summary());
+    m_renderStatisticsLabel->adjustSize();
+
+    m_renderStatisticsLabel->move(viewport()->pos() + QPoint(10, 10));
+    m_renderStatisticsLabel->raise();
+}
+
 void DocumentView::on_temporaryHighlight_timeout()
 {
     m_highlight->setVisible(false);
@@ -1344,7 +1745,9 @@ void DocumentView::on_searchTask_resultsReady(int index, const QList< QRectF >&
         m_thumbnailItems.at(index)->setHighlights(results);
     }
 
-    if(s_settings->documentView().limitThumbnailsToResults())
+    // pages without results do not change which thumbnails are shown
+
+    if(s_settings->documentView().limitThumbnailsToResults() && !results.isEmpty())
     {
         prepareThumbnailsScene();
     }
@@ -1357,11 +1760,93 @@ void DocumentView::on_searchTask_resultsReady(int index, const QList< QRectF >&
     }
 }
 
-void DocumentView::on_pages_cropRectChanged()
+void DocumentView::on_searchIndex_finished()
+{
+    if(m_searchIndex->isReady())
+    {
+        Database::instance()->saveSearchIndex(m_fileInfo.absoluteFilePath(), m_fileInfo.lastModified(), m_searchIndex->save());
+    }
+}
+
+void DocumentView::on_documentLoader_pagesLoaded()
 {
+    const QVector< Model::Page* > pages = m_documentLoader->takePages();
+
+    if(pages.isEmpty())
+    {
+        return;
+    }
+
     qreal left = 0.0, top = 0.0;
     saveLeftAndTop(left, top);
 
+    const int beginAtIndex = m_pages.count();
+
+    m_pages += pages;
+
+    preparePages(beginAtIndex);
+    prepareThumbnails(beginAtIndex);
+    prepareDiskCache();
+
+    MemoryManager::instance()->update();
+
+    prepareScene();
+    prepareView(left, top);
+
+    prepareThumbnailsScene(beginAtIndex);
+
+    emit numberOfPagesChanged(m_pages.count());
+
+    prepareLoadingLabel();
+
+    if(m_pendingJump.page > 0 && m_pendingJump.page <= m_pages.count())
+    {
+        jumpToPage(m_pendingJump.page, false, m_pendingJump.left, m_pendingJump.top);
+    }
+}
+
+void DocumentView::on_documentLoader_finished()
+{
+    // a canceled run might finish after the next one was started
+
+    if(!m_documentIsLoading || m_documentLoader->isRunning())
+    {
+        return;
+    }
+
+    on_documentLoader_pagesLoaded();
+
+    m_documentIsLoading = false;
+    m_pendingJump = Position();
+
+    prepareLoadingLabel();
+
+    // a document missing some of its pages is not presented as a shorter one
+
+    const int failedIndex = m_documentLoader->failedIndex();
+
+    if(failedIndex >= 0)
+    {
+        emit loadingFailed(failedIndex + 1);
+
+        return;
+    }
+
+    if(m_outlineModel->invisibleRootItem()->data().toBool())
+    {
+        loadFallbackOutline();
+    }
+
+    prepareSearchIndex();
+}
+
+void DocumentView::on_pages_cropRectChanged()
+{
+    qreal left = 0.0, top = 0.0;
+    saveLeftAndTop(left, top);
+
+    m_layoutIsPrepared = false;
+
     prepareScene();
     prepareView(left, top);
 }
@@ -1492,6 +1977,21 @@ void DocumentView::on_pages_zoomToSelectionRequested(int page, const QRectF& rec
 
 void DocumentView::on_pages_wasModified()
 {
+    if(!m_wasModified)
+    {
+        // renderings of the modified document must not end up in the disk cache
+
+        foreach(PageItem* page, m_pageItems)
+        {
+            page->setDocumentKey(QByteArray());
+        }
+
+        foreach(ThumbnailItem* page, m_thumbnailItems)
+        {
+            page->setDocumentKey(QByteArray());
+        }
+    }
+
     m_wasModified = true;
 
     emit documentModified();
@@ -1509,6 +2009,12 @@ void DocumentView::resizeEvent(QResizeEvent* event)
         prepareScene();
         prepareView(left, top);
     }
+    else
+    {
+        m_renderScheduler->setViewport(mapToScene(viewport()->rect()).boundingRect());
+    }
+
+    prepareLoadingLabel();
 }
 
 void DocumentView::keyPressEvent(QKeyEvent* event)
@@ -1984,8 +2490,10 @@ bool DocumentView::printUsingQt(QPrinter* printer, const PrintOptions& printOpti
     return true;
 }
 
-void DocumentView::saveLeftAndTop(qreal& left, qreal& top) const
+void DocumentView::saveLeftAndTop(qreal& left, qreal& top)
 {
+    preparePageItem(m_currentPage - 1);
+
     const PageItem* page = m_pageItems.at(m_currentPage - 1);
 
     const QRectF boundingRect = page->boundingRect().translated(page->pos());
@@ -1995,15 +2503,53 @@ void DocumentView::saveLeftAndTop(qreal& left, qreal& top) const
     top = (topLeft.y() - boundingRect.y()) / boundingRect.height();
 }
 
-bool DocumentView::checkDocument(const QString& filePath, Model::Document* document, QVector< Model::Page* >& pages)
+Model::Document* DocumentView::loadDocument(const QString& filePath, QVector< Model::Page* >& pages)
 {
+    // another document must not be opened while waiting for the current one, e.g. by the auto-refresh timer
+
+    if(m_documentIsOpening)
+    {
+        return 0;
+    }
+
+    Plugin* plugin = PluginHandler::instance()->findPlugin(filePath);
+
+    if(plugin == 0)
+    {
+        return 0;
+    }
+
+    // the file is parsed on a worker thread so that the window keeps painting, but user input is held back until it is done
+
+    m_documentIsOpening = true;
+
+    DocumentLoader documentLoader;
+    QEventLoop eventLoop;
+
+    connect(&documentLoader, SIGNAL(documentLoaded()), &eventLoop, SLOT(quit()));
+
+    documentLoader.load(plugin, filePath);
+    eventLoop.exec(QEventLoop::ExcludeUserInputEvents);
+    documentLoader.wait();
+
+    m_documentIsOpening = false;
+
+    Model::Document* document = documentLoader.takeDocument();
+
+    if(document == 0)
+    {
+        return 0;
+    }
+
     if(document->isLocked())
     {
         QString password = QInputDialog::getText(this, tr("Unlock %1").arg(QFileInfo(filePath).completeBaseName()), tr("Password:"), QLineEdit::Password);
 
         if(document->unlock(password))
         {
-            return false;
+            delete document;
+
+            return 0;
         }
     }
 
@@ -2013,12 +2559,18 @@ bool DocumentView::checkDocument(const QString& filePath, Model::Document* docum
     {
         qWarning() << "No pages were found in document at" << filePath;
 
-        return false;
+        delete document;
+
+        return 0;
     }
 
-    pages.reserve(numberOfPages);
+    // only the first pages are loaded here, the document loader appends the remaining ones
 
-    for(int index = 0; index < numberOfPages; ++index)
+    const int loadedPages = qMin(numberOfPages, initiallyLoadedPages);
+
+    pages.reserve(loadedPages);
+
+    for(int index = 0; index < loadedPages; ++index)
     {
         Model::Page* page = document->page(index);
 
@@ -2026,13 +2578,31 @@ bool DocumentView::checkDocument(const QString& filePath, Model::Document* docum
         {
             qWarning() << "No page" << index << "was found in document at" << filePath;
 
-            return false;
+            qDeleteAll(pages);
+            pages.clear();
+
+            delete document;
+
+            return 0;
         }
 
         pages.append(page);
     }
 
-    return true;
+    return document;
+}
+
+void DocumentView::cancelLoading()
+{
+    m_documentLoader->cancel();
+    m_documentLoader->wait();
+
+    qDeleteAll(m_documentLoader->takePages());
+
+    m_documentIsLoading = false;
+    m_pendingJump = Position();
+
+    prepareLoadingLabel();
 }
 
 void DocumentView::loadFallbackOutline()
@@ -2107,9 +2677,13 @@ void DocumentView::prepareDocument(Model::Document* document, const QVector< Mod
     m_prefetchTimer->blockSignals(true);
     m_prefetchTimer->stop();
 
+    cancelLoading();
+
     cancelSearch();
     clearResults();
 
+    m_searchIndex->clear();
+
     qDeleteAll(m_pageItems);
     qDeleteAll(m_thumbnailItems);
 
@@ -2134,6 +2708,24 @@ void DocumentView::prepareDocument(Model::Document* document, const QVector< Mod
     preparePages();
     prepareThumbnails();
     prepareBackground();
+    prepareDiskCache();
+    prepareRenderStatistics();
+
+    if(m_pages.count() < m_document->numberOfPages())
+    {
+        m_documentIsLoading = true;
+        m_documentLoader->start(m_document, m_pages.count());
+    }
+    else
+    {
+        prepareSearchIndex();
+    }
+
+    prepareLoadingLabel();
+
+    // the newly opened document is accounted for in the available memory
+
+    MemoryManager::instance()->update();
 
     m_document->loadOutline(m_outlineModel);
     m_document->loadProperties(m_propertiesModel);
@@ -2150,17 +2742,31 @@ void DocumentView::prepareDocument(Model::Document* document, const QVector< Mod
     }
 }
 
-void DocumentView::preparePages()
+void DocumentView::preparePages(int beginAtIndex)
 {
-    m_pageItems.clear();
+    if(beginAtIndex == 0)
+    {
+        m_pageItems.clear();
+        m_preparedPages.clear();
+
+        m_visiblePages = qMakePair(0, -1);
+        m_retainedPages = qMakePair(0, -1);
+        m_prefetchedPages = qMakePair(0, -1);
+    }
+
     m_pageItems.reserve(m_pages.count());
 
-    for(int index = 0; index < m_pages.count(); ++index)
+    m_layoutIsPrepared = false;
+
+    for(int index = beginAtIndex; index < m_pages.count(); ++index)
     {
         PageItem* page = new PageItem(m_pages.at(index), index);
 
         page->setInvertColors(m_invertColors);
         page->setRubberBandMode(m_rubberBandMode);
+        page->setRenderScheduler(m_renderScheduler);
+
+        page->setVisible(false);
 
         scene()->addItem(page);
         m_pageItems.append(page);
@@ -2180,16 +2786,31 @@ void DocumentView::preparePages()
     }
 }
 
-void DocumentView::prepareThumbnails()
+void DocumentView::prepareThumbnails(int beginAtIndex)
 {
-    m_thumbnailItems.clear();
+    if(beginAtIndex == 0)
+    {
+        m_thumbnailItems.clear();
+
+        m_thumbnailsIndices.clear();
+        m_thumbnailsBegins.clear();
+        m_thumbnailsEnds.clear();
+
+        m_visibleThumbnails = qMakePair(0, -1);
+        m_preparedThumbnails.clear();
+
+        m_highlightedThumbnail = -1;
+    }
+
     m_thumbnailItems.reserve(m_pages.count());
 
-    for(int index = 0; index < m_pages.count(); ++index)
+    for(int index = beginAtIndex; index < m_pages.count(); ++index)
     {
         ThumbnailItem* page = new ThumbnailItem(m_pages.at(index), pageLabelFromNumber(index + 1), index);
 
+        page->setVisible(false);
         page->setInvertColors(m_invertColors);
+        page->setRenderScheduler(m_thumbnailsRenderScheduler);
 
         m_thumbnailsScene->addItem(page);
         m_thumbnailItems.append(page);
@@ -2200,6 +2821,86 @@ void DocumentView::prepareThumbnails()
     }
 }
 
+void DocumentView::prepareDiskCache()
+{
+    QByteArray documentKey;
+
+    const int diskCacheSize = s_settings->pageItem().diskCacheSize();
+
+    DiskCache::instance()->setMaximumSize(diskCacheSize);
+
+    if(diskCacheSize > 0)
+    {
+        m_fileInfo.refresh();
+
+        // the plug-in and its render settings determine the rendered pixels as well
+
+        documentKey = m_fileInfo.absoluteFilePath().toUtf8() + '\0'
+                + QByteArray::number(m_fileInfo.size()) + '\0'
+                + QByteArray::number(m_fileInfo.lastModified().toTime_t()) + '\0'
+                + m_document->renderKey();
+    }
+
+    foreach(PageItem* page, m_pageItems)
+    {
+        page->setDocumentKey(documentKey);
+    }
+
+    foreach(ThumbnailItem* page, m_thumbnailItems)
+    {
+        page->setDocumentKey(documentKey);
+    }
+}
+
+void DocumentView::prepareRenderStatistics()
+{
+    if(s_settings->documentView().showRenderStatistics())
+    {
+        // collection keeps running once enabled so that the totals stay consistent
+
+        RenderStatistics::setEnabled(true);
+
+        on_renderStatistics_timeout();
+
+        m_renderStatisticsLabel->setVisible(true);
+        m_renderStatisticsTimer->start();
+    }
+    else
+    {
+        m_renderStatisticsLabel->setVisible(false);
+        m_renderStatisticsTimer->stop();
+    }
+}
+
+void DocumentView::prepareLoadingLabel()
+{
+    if(!m_documentIsLoading)
+    {
+        m_loadingLabel->setVisible(false);
+
+        return;
+    }
+
+    m_loadingLabel->setText(tr("Loaded %1 of %2 pages").arg(m_pages.count()).arg(m_document->numberOfPages()));
+    m_loadingLabel->adjustSize();
+
+    m_loadingLabel->move(viewport()->pos() + QPoint(10, viewport()->height() - m_loadingLabel->height() - 10));
+    m_loadingLabel->setVisible(true);
+    m_loadingLabel->raise();
+}
+
+void DocumentView::prepareSearchIndex()
+{
+    m_fileInfo.refresh();
+
+    const QByteArray searchIndex = Database::instance()->loadSearchIndex(m_fileInfo.absoluteFilePath(), m_fileInfo.lastModified());
+
+    if(!m_searchIndex->restore(searchIndex, m_pages.count()))
+    {
+        m_searchIndex->start(m_pages);
+    }
+}
+
 void DocumentView::prepareBackground()
 {
     QColor backgroundColor;
@@ -2222,57 +2923,166 @@ void DocumentView::prepareBackground()
     m_thumbnailsScene->setBackgroundBrush(QBrush(backgroundColor));
 }
 
-void DocumentView::prepareScene()
+void DocumentView::prepareLayout(qreal visibleWidth, qreal visibleHeight)
 {
-    // prepare scale factor and rotation
+    // the unit sizes only change with the pages, the rotation, the resolution or the scale mode
+
+    const RenderResolution resolution(logicalDpiX(), logicalDpiY());
+
+    QVector< QSizeF > unitSizes;
+    unitSizes.reserve(m_pageItems.count());
+
+    bool uniformAspectRatio = true;
+
+    foreach(const PageItem* page, m_pageItems)
+    {
+        const QSizeF displayedSize = page->displayedSize(resolution, m_rotation);
+
+        if(m_scaleMode == ScaleFactorMode)
+        {
+            unitSizes.append(displayedSize);
+        }
+        else
+        {
+            unitSizes.append(QSizeF(1.0, displayedSize.height() / displayedSize.width()));
+
+            uniformAspectRatio = uniformAspectRatio && qFuzzyCompare(unitSizes.last().height(), unitSizes.first().height());
+        }
+    }
+
+    m_layoutIsPrepared = true;
+
+    if(m_scaleMode == FitToPageSizeMode && !uniformAspectRatio)
+    {
+        // pages of differing aspect ratios are laid out at their displayed size which depends on the viewport
+
+        for(int index = 0; index < unitSizes.count(); ++index)
+        {
+            const qreal aspectRatio = unitSizes.at(index).height();
+
+            unitSizes[index] = QSizeF(qMin(visibleWidth, visibleHeight / aspectRatio),
+                                      qMin(visibleWidth * aspectRatio, visibleHeight));
+        }
+
+        m_layoutIsPrepared = false;
+    }
+
+    m_layout->prepareLayout(unitSizes, m_rightToLeftMode);
+}
 
+void DocumentView::prepareScene()
+{
     const qreal visibleWidth = m_layout->visibleWidth(viewport()->width());
     const qreal visibleHeight = m_layout->visibleHeight(viewport()->height());
 
-    foreach(PageItem* page, m_pageItems)
+    if(!m_layoutIsPrepared)
+    {
+        prepareLayout(visibleWidth, visibleHeight);
+    }
+
+    // prepare scale
+
+    qreal scale = 1.0;
+
+    switch(m_scaleMode)
+    {
+    default:
+    case ScaleFactorMode:
+        scale = m_scaleFactor;
+        break;
+    case FitToPageWidthMode:
+        scale = visibleWidth;
+        break;
+    case FitToPageSizeMode:
+        if(m_layoutIsPrepared && !m_pageItems.isEmpty())
+        {
+            const QSizeF displayedSize = m_pageItems.first()->displayedSize(RenderResolution(logicalDpiX(), logicalDpiY()), m_rotation);
+
+            scale = qMin(visibleWidth, visibleHeight * displayedSize.width() / displayedSize.height());
+        }
+        break;
+    }
+
+    m_layout->setScale(scale);
+
+    // the pages are prepared again once they are near the viewport
+
+    foreach(int index, m_preparedPages)
+    {
+        PageItem* page = m_pageItems.at(index);
+
+        page->setVisible(false);
+
+        page->cancelRender();
+    }
+
+    m_preparedPages.clear();
+
+    scene()->setSceneRect(m_layout->sceneRect());
+}
+
+void DocumentView::preparePageItem(int index)
+{
+    if(index < 0 || index >= m_pageItems.count() || m_preparedPages.contains(index))
     {
+        return;
+    }
+
+    m_preparedPages.insert(index);
+
+    PageItem* page = m_pageItems.at(index);
+
+    // prepare scale factor and rotation
+
 #if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
 
-        page->setDevicePixelRatio(devicePixelRatio());
+    page->setDevicePixelRatio(devicePixelRatio());
 
 #endif // QT_VERSION
 
-        page->setResolution(logicalDpiX(), logicalDpiY());
+    page->setResolution(logicalDpiX(), logicalDpiY());
 
-        page->setRotation(m_rotation);
+    page->setRotation(m_rotation);
 
-        const qreal displayedWidth = page->displayedWidth();
-        const qreal displayedHeight = page->displayedHeight();
+    const qreal visibleWidth = m_layout->visibleWidth(viewport()->width());
+    const qreal visibleHeight = m_layout->visibleHeight(viewport()->height());
 
-        switch(m_scaleMode)
-        {
-        default:
-        case ScaleFactorMode:
-            page->setScaleFactor(m_scaleFactor);
-            break;
-        case FitToPageWidthMode:
-            page->setScaleFactor(visibleWidth / displayedWidth);
-            break;
-        case FitToPageSizeMode:
-            page->setScaleFactor(qMin(visibleWidth / displayedWidth, visibleHeight / displayedHeight));
-            break;
-        }
+    const qreal displayedWidth = page->displayedWidth();
+    const qreal displayedHeight = page->displayedHeight();
+
+    switch(m_scaleMode)
+    {
+    default:
+    case ScaleFactorMode:
+        page->setScaleFactor(m_scaleFactor);
+        break;
+    case FitToPageWidthMode:
+        page->setScaleFactor(visibleWidth / displayedWidth);
+        break;
+    case FitToPageSizeMode:
+        page->setScaleFactor(qMin(visibleWidth / displayedWidth, visibleHeight / displayedHeight));
+        break;
     }
 
-    // prepare layout
+    // prepare position
 
-    qreal left = 0.0;
-    qreal right = 0.0;
-    qreal height = s_settings->documentView().pageSpacing();
+    page->setPos(m_layout->pagePos(index, page->boundingRect()));
 
-    m_layout->prepareLayout(m_pageItems, m_rightToLeftMode,
-                            left, right, height);
+    page->setVisible(m_continuousMode || m_layout->leftIndex(index) == m_currentPage - 1);
+}
 
-    scene()->setSceneRect(left, 0.0, right - left, height);
+void DocumentView::preparePageItems(const QPair< int, int >& pages)
+{
+    for(int index = pages.first; index <= pages.second; ++index)
+    {
+        preparePageItem(index);
+    }
 }
 
 void DocumentView::prepareView(qreal changeLeft, qreal changeTop, int visiblePage)
 {
+    const qreal pageSpacing = s_settings->documentView().pageSpacing();
+
     qreal left = scene()->sceneRect().left();
     qreal top = scene()->sceneRect().top();
     qreal width = scene()->sceneRect().width();
@@ -2283,126 +3093,263 @@ void DocumentView::prepareView(qreal changeLeft, qreal changeTop, int visiblePag
 
     visiblePage = visiblePage == 0 ? m_currentPage : visiblePage;
 
-    const int highlightIsOnPage = m_currentResult.isValid() ? pageOfResult(m_currentResult) : 0;
-    const bool highlightCurrentThumbnail = s_settings->documentView().highlightCurrentThumbnail();
-
-    for(int index = 0; index < m_pageItems.count(); ++index)
+    foreach(int index, m_preparedPages)
     {
         PageItem* page = m_pageItems.at(index);
-        const QRectF boundingRect = page->boundingRect().translated(page->pos());
 
-        if(m_continuousMode)
+        if(m_continuousMode || m_layout->leftIndex(index) == m_currentPage - 1)
         {
             page->setVisible(true);
         }
         else
         {
-            if(m_layout->leftIndex(index) == m_currentPage - 1)
-            {
-                page->setVisible(true);
-
-                top = boundingRect.top() - s_settings->documentView().pageSpacing();
-                height = boundingRect.height() + 2.0 * s_settings->documentView().pageSpacing();
-            }
-            else
-            {
-                page->setVisible(false);
+            page->setVisible(false);
 
-                page->cancelRender();
-            }
+            page->cancelRender();
         }
+    }
 
-        if(index == visiblePage - 1)
-        {
-            horizontalValue = qFloor(boundingRect.left() + changeLeft * boundingRect.width());
-            verticalValue = qFloor(boundingRect.top() + changeTop * boundingRect.height());
-        }
+    if(!m_continuousMode && m_currentPage >= 1 && m_currentPage <= m_pageItems.count())
+    {
+        const QRectF rowRect = m_layout->rowRect(m_currentPage - 1);
 
-        if(index == highlightIsOnPage - 1)
-        {
-            m_highlight->setPos(page->pos());
-            m_highlight->setTransform(page->transform());
+        top = rowRect.top() - pageSpacing;
+        height = rowRect.height() + 2.0 * pageSpacing;
+    }
 
-            page->stackBefore(m_highlight);
-        }
+    if(visiblePage >= 1 && visiblePage <= m_pageItems.count())
+    {
+        preparePageItem(visiblePage - 1);
+
+        const PageItem* page = m_pageItems.at(visiblePage - 1);
+        const QRectF boundingRect = page->boundingRect().translated(page->pos());
+
+        horizontalValue = qFloor(boundingRect.left() + changeLeft * boundingRect.width());
+        verticalValue = qFloor(boundingRect.top() + changeTop * boundingRect.height());
+    }
+
+    const int highlightIsOnPage = m_currentResult.isValid() ? pageOfResult(m_currentResult) : 0;
+
+    if(highlightIsOnPage >= 1 && highlightIsOnPage <= m_pageItems.count())
+    {
+        preparePageItem(highlightIsOnPage - 1);
 
-        m_thumbnailItems.at(index)->setHighlighted(highlightCurrentThumbnail && (index == m_currentPage - 1));
+        PageItem* page = m_pageItems.at(highlightIsOnPage - 1);
+
+        m_highlight->setPos(page->pos());
+        m_highlight->setTransform(page->transform());
+
+        page->stackBefore(m_highlight);
     }
 
+    prepareCurrentThumbnail();
+
     setSceneRect(left, top, width, height);
 
     horizontalScrollBar()->setValue(horizontalValue);
     verticalScrollBar()->setValue(verticalValue);
 
+    // the scroll bars might not have moved, so the pages near the viewport are prepared here as well
+
+    const QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
+
+    m_renderScheduler->setViewport(visibleRect);
+
+    preparePageItems(m_layout->visiblePages(visibleRect.top() - visibleRect.height(), visibleRect.bottom() + visibleRect.height()));
+
+    // outside of continuous mode, the current row is all that is shown and the scroll handler does not track it
+
+    if(m_continuousMode)
+    {
+        m_visiblePages = m_layout->visiblePages(visibleRect.top(), visibleRect.bottom());
+    }
+    else if(m_currentPage >= 1 && m_currentPage <= m_pageItems.count())
+    {
+        m_visiblePages = qMakePair(m_currentPage - 1, m_layout->rightIndex(m_currentPage - 1, m_pageItems.count()));
+    }
+
     viewport()->update();
 }
 
-void DocumentView::prepareThumbnailsScene()
+void DocumentView::prepareThumbnailsScene(int beginAtIndex)
 {
     const qreal thumbnailSpacing = s_settings->documentView().thumbnailSpacing();
+    const qreal thumbnailSize = s_settings->documentView().thumbnailSize();
+
+    const bool limitThumbnailsToResults = s_settings->documentView().limitThumbnailsToResults() && s_searchModel->hasResults(this);
 
-    qreal left = 0.0;
-    qreal right = m_thumbnailsOrientation == Qt::Vertical ? 0.0 : thumbnailSpacing;
-    qreal top = 0.0;
-    qreal bottom = m_thumbnailsOrientation == Qt::Vertical ? thumbnailSpacing : 0.0;
+    // as for the pages, the positions are computed from the page sizes alone and only applied to the thumbnails near the viewport
 
-    const bool limitThumbnailsToResults = s_settings->documentView().limitThumbnailsToResults();
+    qreal begin = thumbnailSpacing;
+    qreal breadth = 0.0;
 
-    for(int index = 0; index < m_thumbnailItems.count(); ++index)
+    QSet< int > releasedThumbnails;
+
+    if(beginAtIndex > 0 && !limitThumbnailsToResults && beginAtIndex == m_thumbnailsIndices.count())
     {
-        ThumbnailItem* page = m_thumbnailItems.at(index);
+        // the thumbnails of pages loaded in the background are appended to the existing layout
 
-        if(limitThumbnailsToResults && s_searchModel->hasResults(this) && !s_searchModel->hasResultsOnPage(this, index + 1))
-        {
-            page->setVisible(false);
+        const QRectF sceneRect = m_thumbnailsScene->sceneRect();
 
-            page->cancelRender();
+        begin = m_thumbnailsEnds.isEmpty() ? thumbnailSpacing : m_thumbnailsEnds.last();
+        breadth = m_thumbnailsOrientation == Qt::Vertical ? sceneRect.right() : sceneRect.bottom();
+    }
+    else
+    {
+        beginAtIndex = 0;
 
-            continue;
-        }
+        m_thumbnailsIndices.clear();
+        m_thumbnailsBegins.clear();
+        m_thumbnailsEnds.clear();
 
-        page->setVisible(true);
+        m_visibleThumbnails = qMakePair(0, -1);
 
-        // prepare scale factor
+        releasedThumbnails = m_preparedThumbnails;
+        m_preparedThumbnails.clear();
+    }
 
-#if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
+    const QVector< int > pagesWithResults = limitThumbnailsToResults ? s_searchModel->pagesWithResults(this) : QVector< int >();
+    const int count = limitThumbnailsToResults ? pagesWithResults.count() : m_thumbnailItems.count();
 
-        page->setDevicePixelRatio(devicePixelRatio());
+    const RenderResolution resolution(logicalDpiX(), logicalDpiY());
 
-#endif // QT_VERSION
+    for(int position = beginAtIndex; position < count; ++position)
+    {
+        const int index = limitThumbnailsToResults ? pagesWithResults.at(position) - 1 : position;
+
+        if(index < 0 || index >= m_thumbnailItems.count())
+        {
+            continue;
+        }
 
-        page->setResolution(logicalDpiX(), logicalDpiY());
+        const ThumbnailItem* page = m_thumbnailItems.at(index);
 
-        page->setScaleFactor(qMin(s_settings->documentView().thumbnailSize() / page->displayedWidth(),
-                                  s_settings->documentView().thumbnailSize() / page->displayedHeight()));
+        const QSizeF displayedSize = page->displayedSize(resolution, RotateBy0);
+        const qreal scaleFactor = qMin(thumbnailSize / displayedSize.width(), thumbnailSize / displayedSize.height());
 
-        // prepare layout
+        const qreal width = scaleFactor * displayedSize.width();
+        const qreal height = scaleFactor * displayedSize.height() + page->textHeight();
 
-        const QRectF boundingRect = page->boundingRect();
+        m_thumbnailsIndices.append(index);
+        m_thumbnailsBegins.append(begin);
 
         if(m_thumbnailsOrientation == Qt::Vertical)
         {
-            page->setPos(-boundingRect.left() - 0.5 * boundingRect.width(), bottom - boundingRect.top());
-
-            left = qMin(left, -0.5f * boundingRect.width() - thumbnailSpacing);
-            right = qMax(right, 0.5f * boundingRect.width() + thumbnailSpacing);
-            bottom += boundingRect.height() + thumbnailSpacing;
+            breadth = qMax(breadth, 0.5 * width + thumbnailSpacing);
+            begin += height + thumbnailSpacing;
         }
         else
         {
-            page->setPos(right - boundingRect.left(), -boundingRect.top() - 0.5 * boundingRect.height());
+            breadth = qMax(breadth, 0.5 * height + thumbnailSpacing);
+            begin += width + thumbnailSpacing;
+        }
+
+        m_thumbnailsEnds.append(begin);
+    }
+
+    if(m_thumbnailsOrientation == Qt::Vertical)
+    {
+        m_thumbnailsScene->setSceneRect(-breadth, 0.0, 2.0 * breadth, begin);
+    }
+    else
+    {
+        m_thumbnailsScene->setSceneRect(0.0, -breadth, begin, 2.0 * breadth);
+    }
+
+    setThumbnailsViewport(m_thumbnailsViewport);
+
+    prepareCurrentThumbnail();
+
+    // thumbnails which were prepared before but are no longer near the viewport are hidden only now so that the others keep rendering
+
+    foreach(int index, releasedThumbnails)
+    {
+        if(!m_preparedThumbnails.contains(index))
+        {
+            ThumbnailItem* page = m_thumbnailItems.at(index);
 
-            top = qMin(top, -0.5f * boundingRect.height() - thumbnailSpacing);
-            bottom = qMax(bottom, 0.5f * boundingRect.height() + thumbnailSpacing);
-            right += boundingRect.width() + thumbnailSpacing;
+            page->setVisible(false);
+
+            page->cancelRender();
         }
     }
+}
+
+void DocumentView::prepareThumbnailItem(int position)
+{
+    const int index = m_thumbnailsIndices.at(position);
+
+    if(m_preparedThumbnails.contains(index))
+    {
+        return;
+    }
+
+    m_preparedThumbnails.insert(index);
+
+    ThumbnailItem* page = m_thumbnailItems.at(index);
 
-    m_thumbnailsScene->setSceneRect(left, top, right - left, bottom - top);
+    // prepare scale factor
+
+#if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
+
+    page->setDevicePixelRatio(devicePixelRatio());
+
+#endif // QT_VERSION
+
+    page->setResolution(logicalDpiX(), logicalDpiY());
+
+    const qreal thumbnailSize = s_settings->documentView().thumbnailSize();
+
+    page->setScaleFactor(qMin(thumbnailSize / page->displayedWidth(),
+                              thumbnailSize / page->displayedHeight()));
+
+    // prepare position
+
+    const QRectF boundingRect = page->boundingRect();
+    const qreal begin = m_thumbnailsBegins.at(position);
+
+    if(m_thumbnailsOrientation == Qt::Vertical)
+    {
+        page->setPos(-boundingRect.left() - 0.5 * boundingRect.width(), begin - boundingRect.top());
+    }
+    else
+    {
+        page->setPos(begin - boundingRect.left(), -boundingRect.top() - 0.5 * boundingRect.height());
+    }
+
+    page->setVisible(true);
+}
+
+void DocumentView::prepareCurrentThumbnail()
+{
+    if(m_highlightedThumbnail != -1)
+    {
+        m_thumbnailItems.at(m_highlightedThumbnail)->setHighlighted(false);
+    }
+
+    const bool highlightCurrentThumbnail = s_settings->documentView().highlightCurrentThumbnail();
+
+    m_highlightedThumbnail = highlightCurrentThumbnail && m_currentPage >= 1 && m_currentPage <= m_thumbnailItems.count() ? m_currentPage - 1 : -1;
+
+    if(m_highlightedThumbnail != -1)
+    {
+        m_thumbnailItems.at(m_highlightedThumbnail)->setHighlighted(true);
+    }
+
+    // the current thumbnail is prepared even if far away so that the thumbnails view can scroll to it
+
+    const QVector< int >::const_iterator position = qBinaryFind(m_thumbnailsIndices.constBegin(), m_thumbnailsIndices.constEnd(), m_currentPage - 1);
+
+    if(position != m_thumbnailsIndices.constEnd())
+    {
+        prepareThumbnailItem(position - m_thumbnailsIndices.constBegin());
+    }
 }
 
 void DocumentView::prepareHighlight(int index, const QRectF& rect)
 {
+    preparePageItem(index);
+
     PageItem* page = m_pageItems.at(index);
 
     m_highlight->setPos(page->pos());
@@ -2419,6 +3366,8 @@ void DocumentView::prepareHighlight(int index, const QRectF& rect)
     centerOn(m_highlight);
     connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(on_verticalScrollBar_valueChanged()));
 
+    m_renderScheduler->setViewport(mapToScene(viewport()->rect()).boundingRect());
+
     viewport()->update();
 }
 
@@ -24,13 +24,16 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DOCUMENTVIEW_H
 #define DOCUMENTVIEW_H
 
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QGraphicsView>
 #include <QMap>
 #include <QPersistentModelIndex>
+#include <QSet>
 
 class QDomNode;
 class QFileSystemWatcher;
+class QLabel;
 class QPrinter;
 class QStandardItemModel;
 
@@ -52,7 +55,10 @@ class PageItem;
 class ThumbnailItem;
 class SearchModel;
 class SearchTask;
+class SearchIndex;
+class DocumentLoader;
 class PresentationView;
+class RenderScheduler;
 class ShortcutHandler;
 class MainWindow;
 struct DocumentLayout;
@@ -118,6 +124,7 @@ public:
     void setRubberBandMode(RubberBandMode rubberBandMode);
 
     bool searchWasCanceled() const;
+    bool searchIsRunning() const;
     int searchProgress() const;
 
     inline Qt::Orientation thumbnailsOrientation() const { return m_thumbnailsOrientation; }
@@ -126,6 +133,8 @@ public:
     inline const QVector< ThumbnailItem* >& thumbnailItems() const { return m_thumbnailItems; }
     inline QGraphicsScene* thumbnailsScene() const { return m_thumbnailsScene; }
 
+    void setThumbnailsViewport(const QRectF& thumbnailsViewport);
+
     inline QStandardItemModel* outlineModel() const { return m_outlineModel; }
     inline QStandardItemModel* propertiesModel() const { return m_propertiesModel; }
 
@@ -163,6 +172,8 @@ signals:
     void searchFinished();
     void searchProgressChanged(int progress);
 
+    void loadingFailed(int page);
+
 public slots:
     void show();
 
@@ -206,15 +217,26 @@ public slots:
 
 protected slots:
     void on_verticalScrollBar_valueChanged();
+    void on_horizontalScrollBar_valueChanged();
 
     void on_autoRefresh_timeout();
     void on_prefetch_timeout();
+    void on_prefetch_requested();
+
+    void on_memoryManager_budgetsChanged();
+
+    void on_renderStatistics_timeout();
 
     void on_temporaryHighlight_timeout();
 
     void on_searchTask_progressChanged(int progress);
     void on_searchTask_resultsReady(int index, const QList< QRectF >& results);
 
+    void on_searchIndex_finished();
+
+    void on_documentLoader_pagesLoaded();
+    void on_documentLoader_finished();
+
     void on_pages_cropRectChanged();
     void on_thumbnails_cropRectChanged();
 
@@ -249,6 +271,16 @@ private:
 
     QTimer* m_prefetchTimer;
 
+    QElapsedTimer m_scrollTimer;
+    int m_scrollValue;
+    qreal m_scrollVelocity;
+
+    RenderScheduler* m_renderScheduler;
+    RenderScheduler* m_thumbnailsRenderScheduler;
+
+    QLabel* m_renderStatisticsLabel;
+    QTimer* m_renderStatisticsTimer;
+
     Model::Document* m_document;
     QVector< Model::Page* > m_pages;
 
@@ -272,6 +304,7 @@ private:
         qreal left;
         qreal top;
 
+        Position() : page(0), left(0.0), top(0.0) {}
         Position(int page, qreal left, qreal top) : page(page), left(left), top(top) {}
 
     };
@@ -279,7 +312,9 @@ private:
     QList< Position > m_past;
     QList< Position > m_future;
 
-    void saveLeftAndTop(qreal& left, qreal& top) const;
+    Position m_pendingJump;
+
+    void saveLeftAndTop(qreal& left, qreal& top);
 
     QScopedPointer< DocumentLayout > m_layout;
 
@@ -297,15 +332,44 @@ private:
     QVector< PageItem* > m_pageItems;
     QVector< ThumbnailItem* > m_thumbnailItems;
 
+    QPair< int, int > m_visiblePages;
+    QPair< int, int > m_retainedPages;
+    QPair< int, int > m_prefetchedPages;
+
+    // only pages near the viewport are kept up to date with the layout
+
+    bool m_layoutIsPrepared;
+    QSet< int > m_preparedPages;
+
+    int m_highlightedThumbnail;
+
     QGraphicsRectItem* m_highlight;
 
     Qt::Orientation m_thumbnailsOrientation;
     QGraphicsScene* m_thumbnailsScene;
 
+    QVector< int > m_thumbnailsIndices;
+    QVector< qreal > m_thumbnailsBegins;
+    QVector< qreal > m_thumbnailsEnds;
+
+    QPair< int, int > m_visibleThumbnails;
+
+    // only thumbnails near the thumbnails viewport are kept up to date with their layout
+
+    QRectF m_thumbnailsViewport;
+    QSet< int > m_preparedThumbnails;
+
     QStandardItemModel* m_outlineModel;
     QStandardItemModel* m_propertiesModel;
 
-    bool checkDocument(const QString& filePath, Model::Document* document, QVector< Model::Page* >& pages);
+    DocumentLoader* m_documentLoader;
+    bool m_documentIsOpening;
+    bool m_documentIsLoading;
+
+    QLabel* m_loadingLabel;
+
+    Model::Document* loadDocument(const QString& filePath, QVector< Model::Page* >& pages);
+    void cancelLoading();
 
     void loadFallbackOutline();
     void loadDocumentDefaults();
@@ -313,14 +377,23 @@ private:
     void adjustScrollBarPolicy();
 
     void prepareDocument(Model::Document* document, const QVector< Model::Page* >& pages);
-    void preparePages();
-    void prepareThumbnails();
+    void preparePages(int beginAtIndex = 0);
+    void prepareThumbnails(int beginAtIndex = 0);
+    void prepareDiskCache();
+    void prepareSearchIndex();
+    void prepareRenderStatistics();
+    void prepareLoadingLabel();
     void prepareBackground();
 
+    void prepareLayout(qreal visibleWidth, qreal visibleHeight);
     void prepareScene();
+    void preparePageItem(int index);
+    void preparePageItems(const QPair< int, int >& pages);
     void prepareView(qreal changeLeft = 0.0, qreal changeTop = 0.0, int visiblePage = 0);
 
-    void prepareThumbnailsScene();
+    void prepareThumbnailsScene(int beginAtIndex = 0);
+    void prepareThumbnailItem(int position);
+    void prepareCurrentThumbnail();
 
     void prepareHighlight(int index, const QRectF& highlight);
 
@@ -331,6 +404,7 @@ private:
     QPersistentModelIndex m_currentResult;
 
     SearchTask* m_searchTask;
+    SearchIndex* m_searchIndex;
 
     void checkResult();
     void applyResult();
@@ -72,6 +72,10 @@ void loadOutline(fz_outline* outline, QStandardItem* parent)
     }
 }
 
+// the size of a display list is not exposed by MuPDF, so the cache is bounded by the number of pages
+
+const int maximumDisplayLists = 32;
+
 } // anonymous
 
 namespace qpdfview
@@ -80,9 +84,10 @@ namespace qpdfview
 namespace Model
 {
 
-FitzPage::FitzPage(const FitzDocument* parent, fz_page* page) :
+FitzPage::FitzPage(const FitzDocument* parent, fz_page* page, int index) :
     m_parent(parent),
-    m_page(page)
+    m_page(page),
+    m_index(index)
 {
 }
 
@@ -135,11 +140,7 @@ QImage FitzPage::render(qreal horizontalResolution, qreal verticalResolution, Ro
 
 
     fz_context* context = fz_clone_context(m_parent->m_context);
-    fz_display_list* display_list = fz_new_display_list(context);
-
-    fz_device* device = fz_new_list_device(context, display_list);
-    fz_run_page(m_parent->m_document, m_page, device, &matrix, 0);
-    fz_free_device(device);
+    fz_display_list* display_list = m_parent->loadDisplayList(context, m_page, m_index);
 
 
     mutexLocker.unlock();
@@ -167,10 +168,13 @@ QImage FitzPage::render(qreal horizontalResolution, qreal verticalResolution, Ro
     QImage image(tileWidth, tileHeight, QImage::Format_RGB32);
     image.fill(m_parent->m_paperColor);
 
+    fz_matrix tileTransform;
+    fz_concat(&tileTransform, &matrix, &tileMatrix);
+
     fz_pixmap* pixmap = fz_new_pixmap_with_data(context, fz_device_bgr(context), image.width(), image.height(), image.bits());
 
-    device = fz_new_draw_device(context, pixmap);
-    fz_run_display_list(display_list, device, &tileMatrix, &tileRect, 0);
+    fz_device* device = fz_new_draw_device(context, pixmap);
+    fz_run_display_list(display_list, device, &tileTransform, &tileRect, 0);
     fz_free_device(device);
 
     fz_drop_pixmap(context, pixmap);
@@ -240,12 +244,15 @@ FitzDocument::FitzDocument(fz_context* context, fz_document* document) :
     m_mutex(),
     m_context(context),
     m_document(document),
-    m_paperColor(Qt::white)
+    m_paperColor(Qt::white),
+    m_displayLists(maximumDisplayLists)
 {
 }
 
 FitzDocument::~FitzDocument()
 {
+    m_displayLists.clear();
+
     fz_close_document(m_document);
     fz_free_context(m_context);
 }
@@ -263,7 +270,7 @@ Page* FitzDocument::page(int index) const
 
     fz_page* page = fz_load_page(m_document, index);
 
-    return page != 0 ? new FitzPage(this, page) : 0;
+    return page != 0 ? new FitzPage(this, page, index) : 0;
 }
 
 bool FitzDocument::canBePrintedUsingCUPS() const
@@ -278,6 +285,11 @@ void FitzDocument::setPaperColor(const QColor& paperColor)
     m_paperColor = paperColor;
 }
 
+QByteArray FitzDocument::renderKey() const
+{
+    return QByteArray("fitz");
+}
+
 void FitzDocument::loadOutline(QStandardItemModel* outlineModel) const
 {
     Document::loadOutline(outlineModel);
@@ -294,6 +306,39 @@ void FitzDocument::loadOutline(QStandardItemModel* outlineModel) const
     }
 }
 
+FitzDocument::DisplayList::DisplayList(fz_context* context, fz_display_list* list) :
+    context(context),
+    list(list)
+{
+}
+
+FitzDocument::DisplayList::~DisplayList()
+{
+    fz_drop_display_list(context, list);
+}
+
+fz_display_list* FitzDocument::loadDisplayList(fz_context* context, fz_page* page, int index) const
+{
+    const DisplayList* displayList = m_displayLists.object(index);
+
+    if(displayList != 0)
+    {
+        return fz_keep_display_list(context, displayList->list);
+    }
+
+    // record without transformation so that the list can be reused for all tiles and scale factors
+
+    fz_display_list* display_list = fz_new_display_list(context);
+
+    fz_device* device = fz_new_list_device(context, display_list);
+    fz_run_page(m_document, page, device, &fz_identity, 0);
+    fz_free_device(device);
+
+    m_displayLists.insert(index, new DisplayList(m_context, fz_keep_display_list(context, display_list)));
+
+    return display_list;
+}
+
 } // Model
 
 FitzPlugin::FitzPlugin(QObject* parent) : QObject(parent)
@@ -22,6 +22,7 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef FITZMODEL_H
 #define FITZMODEL_H
 
+#include <QCache>
 #include <QMutex>
 
 extern "C"
@@ -31,6 +32,7 @@ extern "C"
 
 typedef struct fz_page_s fz_page;
 typedef struct fz_document_s fz_document;
+typedef struct fz_display_list_s fz_display_list;
 
 }
 
@@ -59,11 +61,12 @@ namespace Model
     private:
         Q_DISABLE_COPY(FitzPage)
 
-        FitzPage(const class FitzDocument* parent, fz_page* page);
+        FitzPage(const class FitzDocument* parent, fz_page* page, int index);
 
         const class FitzDocument* m_parent;
 
         fz_page* m_page;
+        int m_index;
 
     };
 
@@ -83,6 +86,8 @@ namespace Model
 
         void setPaperColor(const QColor &paperColor);
 
+        QByteArray renderKey() const;
+
         void loadOutline(QStandardItemModel* outlineModel) const;
 
     private:
@@ -96,6 +101,20 @@ namespace Model
 
         QColor m_paperColor;
 
+        struct DisplayList
+        {
+            DisplayList(fz_context* context, fz_display_list* list);
+            ~DisplayList();
+
+            fz_context* context;
+            fz_display_list* list;
+
+        };
+
+        mutable QCache< int, DisplayList > m_displayLists;
+
+        fz_display_list* loadDisplayList(fz_context* context, fz_page* page, int index) const;
+
     };
 }
 
@@ -49,6 +49,7 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include "documentview.h"
 #include "database.h"
 #include "mainwindow.h"
+#include "renderstatistics.h"
 
 #ifdef WITH_SIGNALS
 
@@ -98,6 +99,7 @@ bool quiet = false;
 
 QString instanceName;
 QString searchText;
+QString renderStatisticsFilePath;
 
 QList< File > files;
 
@@ -129,6 +131,7 @@ void parseCommandLineArguments()
 {
     bool instanceNameIsNext = false;
     bool searchTextIsNext = false;
+    bool renderStatisticsFilePathIsNext = false;
     bool noMoreOptions = false;
 
     QRegExp fileAndPageRegExp("(.+)#(\\d+)");
@@ -166,6 +169,17 @@ void parseCommandLineArguments()
             searchTextIsNext = false;
             searchText = argument;
         }
+        else if(renderStatisticsFilePathIsNext)
+        {
+            if(argument.isEmpty())
+            {
+                qCritical() << QObject::tr("An empty render statistics file path is not allowed.");
+                exit(ExitIllegalArgument);
+            }
+
+            renderStatisticsFilePathIsNext = false;
+            renderStatisticsFilePath = argument;
+        }
         else if(!noMoreOptions && argument.startsWith("--"))
         {
             if(argument == QLatin1String("--unique"))
@@ -184,6 +198,10 @@ void parseCommandLineArguments()
             {
                 searchTextIsNext = true;
             }
+            else if(argument == QLatin1String("--render-statistics"))
+            {
+                renderStatisticsFilePathIsNext = true;
+            }
             else if(argument == QLatin1String("--choose-instance"))
             {
                 bool ok = false;
@@ -201,6 +219,7 @@ void parseCommandLineArguments()
                           << "Available options:" << std::endl
                           << "  --help                      Show this information" << std::endl
                           << "  --quiet                     Suppress warning messages when opening files" << std::endl
+                          << "  --render-statistics file    Save render statistics to file on exit" << std::endl
                           << "  --search text               Search for text in the current tab" << std::endl
                           << "  --unique                    Open files as tabs in unique window" << std::endl
                           << "  --unique --instance name    Open files as tabs in named instance" << std::endl
@@ -268,6 +287,12 @@ void parseCommandLineArguments()
         qCritical() << QObject::tr("Using '--search' requires a search text.");
         exit(ExitInconsistentArguments);
     }
+
+    if(renderStatisticsFilePathIsNext)
+    {
+        qCritical() << QObject::tr("Using '--render-statistics' requires a file path.");
+        exit(ExitInconsistentArguments);
+    }
 }
 
 void parseWorkbenchExtendedSelection(int argc, char** argv)
@@ -472,6 +497,11 @@ int main(int argc, char** argv)
 
     parseCommandLineArguments();
 
+    if(!renderStatisticsFilePath.isEmpty())
+    {
+        RenderStatistics::setEnabled(true);
+    }
+
     resolveSourceReferences();
 
     activateUniqueInstance();
@@ -491,5 +521,12 @@ int main(int argc, char** argv)
         mainWindow->startSearch(searchText);
     }
 
-    return application.exec();
+    const int exitStatus = application.exec();
+
+    if(!renderStatisticsFilePath.isEmpty() && !RenderStatistics::instance()->save(renderStatisticsFilePath))
+    {
+        qWarning() << QObject::tr("Could not save render statistics to '%1'.").arg(renderStatisticsFilePath);
+    }
+
+    return exitStatus;
 }
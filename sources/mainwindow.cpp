@@ -71,6 +71,7 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include "bookmarkmenu.h"
 #include "bookmarkdialog.h"
 #include "database.h"
+#include "renderstatistics.h"
 
 namespace
 {
@@ -124,7 +125,8 @@ namespace qpdfview
 Settings* MainWindow::s_settings = 0;
 Database* MainWindow::s_database = 0;
 
-MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent)
+MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent),
+    m_searchAllTabs(false)
 {
     s_instance = this;
 
@@ -278,6 +280,8 @@ bool MainWindow::openInNewTab(const QString& filePath, int page, const QRectF& h
         connect(newTab, SIGNAL(searchFinished()), SLOT(on_currentTab_searchFinished()));
         connect(newTab, SIGNAL(searchProgressChanged(int)), SLOT(on_currentTab_searchProgressChanged(int)));
 
+        connect(newTab, SIGNAL(loadingFailed(int)), SLOT(on_currentTab_loadingFailed(int)));
+
         connect(newTab, SIGNAL(customContextMenuRequested(QPoint)), SLOT(on_currentTab_customContextMenuRequested(QPoint)));
 
         newTab->show();
@@ -426,7 +430,7 @@ void MainWindow::on_tabWidget_currentChanged(int index)
         if(m_searchDock->isVisible())
         {
             m_searchLineEdit->stopTimer();
-            m_searchLineEdit->setProgress(currentTab()->searchProgress());
+            m_searchLineEdit->setProgress(m_searchAllTabs ? searchProgressForAllTabs() : currentTab()->searchProgress());
         }
 
         m_outlineView->setModel(currentTab()->outlineModel());
@@ -434,6 +438,8 @@ void MainWindow::on_tabWidget_currentChanged(int index)
         m_bookmarksView->setModel(bookmarkModelForCurrentTab());
         m_thumbnailsView->setScene(currentTab()->thumbnailsScene());
 
+        on_thumbnails_viewportChanged();
+
         on_currentTab_documentChanged();
 
         on_currentTab_numberOfPagesChaned(currentTab()->numberOfPages());
@@ -795,7 +801,13 @@ void MainWindow::on_currentTab_rubberBandModeChanged(RubberBandMode rubberBandMo
 
 void MainWindow::on_currentTab_searchFinished()
 {
-    if(senderIsCurrentTab())
+    if(m_searchAllTabs)
+    {
+        const int progress = searchProgressForAllTabs();
+
+        m_searchLineEdit->setProgress(progress < 100 ? progress : 0);
+    }
+    else if(senderIsCurrentTab())
     {
         m_searchLineEdit->setProgress(0);
     }
@@ -803,12 +815,31 @@ void MainWindow::on_currentTab_searchFinished()
 
 void MainWindow::on_currentTab_searchProgressChanged(int progress)
 {
-    if(senderIsCurrentTab())
+    if(m_searchAllTabs)
+    {
+        m_searchLineEdit->setProgress(searchProgressForAllTabs());
+    }
+    else if(senderIsCurrentTab())
     {
         m_searchLineEdit->setProgress(progress);
     }
 }
 
+void MainWindow::on_currentTab_loadingFailed(int page)
+{
+    for(int index = 0; index < m_tabWidget->count(); ++index)
+    {
+        if(sender() == m_tabWidget->widget(index))
+        {
+            QMessageBox::warning(this, tr("Warning"), tr("Could not load page %1 of '%2'.").arg(page).arg(tab(index)->fileInfo().filePath()));
+
+            closeTab(tab(index));
+
+            break;
+        }
+    }
+}
+
 void MainWindow::on_currentTab_customContextMenuRequested(const QPoint& pos)
 {
     if(senderIsCurrentTab())
@@ -1115,6 +1146,8 @@ void MainWindow::on_findNext_triggered()
 
 void MainWindow::on_cancelSearch_triggered()
 {
+    m_searchAllTabs = false;
+
     m_searchLineEdit->stopTimer();
     m_searchLineEdit->setProgress(0);
 
@@ -1718,6 +1751,8 @@ void MainWindow::on_searchInitiated(const QString& text, bool modified)
     {
         const bool allTabs = s_settings->mainWindow().extendedSearchDock() ? !modified : modified;
 
+        m_searchAllTabs = allTabs;
+
         if(allTabs)
         {
             for(int index = 0; index < m_tabWidget->count(); ++index)
@@ -1861,21 +1896,13 @@ void MainWindow::on_thumbnails_dockLocationChanged(Qt::DockWidgetArea area)
     }
 }
 
-void MainWindow::on_thumbnails_verticalScrollBar_valueChanged(int value)
+void MainWindow::on_thumbnails_viewportChanged()
 {
-    Q_UNUSED(value);
-
     if(m_thumbnailsView->scene() != 0)
     {
         const QRectF visibleRect = m_thumbnailsView->mapToScene(m_thumbnailsView->viewport()->rect()).boundingRect();
 
-        foreach(ThumbnailItem* page, currentTab()->thumbnailItems())
-        {
-            if(!page->boundingRect().translated(page->pos()).intersects(visibleRect))
-            {
-                page->cancelRender();
-            }
-        }
+        currentTab()->setThumbnailsViewport(visibleRect);
     }
 }
 
@@ -2023,6 +2050,8 @@ void MainWindow::on_search_visibilityChanged(bool visible)
 {
     if(!visible)
     {
+        m_searchAllTabs = false;
+
         m_searchLineEdit->stopTimer();
         m_searchLineEdit->setProgress(0);
 
@@ -2163,6 +2192,18 @@ void MainWindow::dropEvent(QDropEvent* event)
     }
 }
 
+bool MainWindow::eventFilter(QObject* target, QEvent* event)
+{
+    // resizing the thumbnails view might reveal thumbnails without moving its scroll bars
+
+    if(target == m_thumbnailsView->viewport() && event->type() == QEvent::Resize)
+    {
+        on_thumbnails_viewportChanged();
+    }
+
+    return QMainWindow::eventFilter(target, event);
+}
+
 void MainWindow::prepareStyle()
 {
     if(s_settings->mainWindow().hasIconTheme())
@@ -2214,6 +2255,23 @@ bool MainWindow::senderIsCurrentTab() const
      return sender() == m_tabWidget->currentWidget() || qobject_cast< DocumentView* >(sender()) == 0;
 }
 
+int MainWindow::searchProgressForAllTabs() const
+{
+    if(m_tabWidget->count() == 0)
+    {
+        return 0;
+    }
+
+    int progress = 0;
+
+    for(int index = 0; index < m_tabWidget->count(); ++index)
+    {
+        progress += tab(index)->searchIsRunning() ? tab(index)->searchProgress() : 100;
+    }
+
+    return progress / m_tabWidget->count();
+}
+
 int MainWindow::addTab(DocumentView* tab)
 {
     const int index = s_settings->mainWindow().newTabNextToCurrentTab() ?
@@ -2248,7 +2306,12 @@ void MainWindow::closeTab(DocumentView* tab)
     }
     else
     {
-        delete tab;
+        // the tab might still be on the stack, e.g. while it asks for a password
+
+        m_tabWidget->removeTab(m_tabWidget->indexOf(tab));
+
+        tab->setVisible(false);
+        tab->deleteLater();
     }
 
     if(s_settings->mainWindow().exitAfterLastTab() && m_tabWidget->count() == 0)
@@ -2803,7 +2866,14 @@ void MainWindow::createDocks()
 
     m_thumbnailsView = new QGraphicsView(this);
 
-    connect(m_thumbnailsView->verticalScrollBar(), SIGNAL(valueChanged(int)), SLOT(on_thumbnails_verticalScrollBar_valueChanged(int)));
+    // the thumbnails near the viewport are only laid out once it reaches them
+
+    connect(m_thumbnailsView->verticalScrollBar(), SIGNAL(valueChanged(int)), SLOT(on_thumbnails_viewportChanged()));
+    connect(m_thumbnailsView->horizontalScrollBar(), SIGNAL(valueChanged(int)), SLOT(on_thumbnails_viewportChanged()));
+    connect(m_thumbnailsView->verticalScrollBar(), SIGNAL(rangeChanged(int,int)), SLOT(on_thumbnails_viewportChanged()));
+    connect(m_thumbnailsView->horizontalScrollBar(), SIGNAL(rangeChanged(int,int)), SLOT(on_thumbnails_viewportChanged()));
+
+    m_thumbnailsView->viewport()->installEventFilter(this);
 
     m_thumbnailsDock->setWidget(m_thumbnailsView);
 
@@ -3132,6 +3202,11 @@ bool MainWindowAdaptor::closeTab(const QString& absoluteFilePath)
     return false;
 }
 
+bool MainWindowAdaptor::saveRenderStatistics(const QString& absoluteFilePath)
+{
+    return RenderStatistics::instance()->save(absoluteFilePath);
+}
+
 MainWindow* MainWindowAdaptor::mainWindow() const
 {
     return qobject_cast< MainWindow* >(parent());
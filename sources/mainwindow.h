@@ -118,6 +118,8 @@ protected slots:
     void on_currentTab_searchFinished();
     void on_currentTab_searchProgressChanged(int progress);
 
+    void on_currentTab_loadingFailed(int page);
+
     void on_currentTab_customContextMenuRequested(const QPoint& pos);
 
     void on_currentPage_editingFinished();
@@ -232,7 +234,7 @@ protected slots:
     void on_properties_sectionCountChanged();
 
     void on_thumbnails_dockLocationChanged(Qt::DockWidgetArea area);
-    void on_thumbnails_verticalScrollBar_valueChanged(int value);
+    void on_thumbnails_viewportChanged();
 
     void on_bookmarks_sectionCountChanged();
     void on_bookmarks_clicked(const QModelIndex& index);
@@ -252,6 +254,8 @@ protected:
     void dragEnterEvent(QDragEnterEvent* event);
     void dropEvent(QDropEvent* event);
 
+    bool eventFilter(QObject* target, QEvent* event);
+
 private:
     Q_DISABLE_COPY(MainWindow)
 
@@ -297,6 +301,10 @@ private:
     QCheckBox* m_matchCaseCheckBox;
     QCheckBox* m_highlightAllCheckBox;
 
+    bool m_searchAllTabs;
+
+    int searchProgressForAllTabs() const;
+
     void createWidgets();
 
     QAction* m_openAction;
@@ -490,6 +498,8 @@ public slots:
 
     bool closeTab(const QString& absoluteFilePath);
 
+    bool saveRenderStatistics(const QString& absoluteFilePath);
+
 private:
     MainWindow* mainWindow() const;
 
@@ -0,0 +1,309 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "memorymanager.h"
+
+#include <QApplication>
+#include <QFile>
+#include <QTimer>
+
+#include "settings.h"
+
+namespace
+{
+
+const int updateInterval = 30 * 1000;
+
+const qint64 minimumAutomaticSize = 32 * 1024 * 1024;
+const qint64 maximumAutomaticSize = 1024 * 1024 * 1024;
+const qint64 fallbackAutomaticSize = 64 * 1024 * 1024;
+
+qint64 readValue(const QString& filePath)
+{
+    QFile file(filePath);
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        return -1;
+    }
+
+    bool ok = false;
+    const qint64 value = file.readLine().trimmed().toLongLong(&ok);
+
+    return ok ? value : -1;
+}
+
+qint64 readMemoryAvailable()
+{
+    QFile file(QLatin1String("/proc/meminfo"));
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        return -1;
+    }
+
+    foreach(const QByteArray& line, file.readAll().split('\n'))
+    {
+        const QList< QByteArray > fields = line.simplified().split(' ');
+
+        if(fields.count() >= 2 && fields.at(0) == "MemAvailable:")
+        {
+            bool ok = false;
+            const qint64 value = fields.at(1).toLongLong(&ok);
+
+            return ok ? 1024 * value : -1;
+        }
+    }
+
+    return -1;
+}
+
+QString readCgroupPath(const QByteArray& controller)
+{
+    // the unified hierarchy is listed with an empty controller, the legacy ones by name
+
+    QFile file(QLatin1String("/proc/self/cgroup"));
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        return QString();
+    }
+
+    foreach(const QByteArray& line, file.readAll().split('\n'))
+    {
+        const int first = line.indexOf(':');
+        const int second = line.indexOf(':', first + 1);
+
+        if(first < 0 || second < 0)
+        {
+            continue;
+        }
+
+        const QByteArray controllers = line.mid(first + 1, second - first - 1);
+
+        if(controller.isEmpty() ? controllers.isEmpty() : controllers.split(',').contains(controller))
+        {
+            QString path = QString::fromLocal8Bit(line.mid(second + 1));
+
+            while(path.endsWith(QLatin1Char('/')))
+            {
+                path.chop(1);
+            }
+
+            if(path.isEmpty())
+            {
+                path = QLatin1String("/");
+            }
+
+            return path;
+        }
+    }
+
+    return QString();
+}
+
+qint64 readCgroupHierarchyAvailable(const QString& mountPoint, const QString& path, const QString& limitName, const QString& usageName)
+{
+    // every ancestor of the process' own group might impose a tighter limit
+
+    qint64 available = -1;
+
+    QString group = path == QLatin1String("/") ? QString() : path;
+
+    while(true)
+    {
+        const qint64 limit = readValue(mountPoint + group + QLatin1Char('/') + limitName);
+        const qint64 usage = readValue(mountPoint + group + QLatin1Char('/') + usageName);
+
+        if(limit >= 0 && usage >= 0)
+        {
+            const qint64 groupAvailable = qMax(limit - usage, qint64(0));
+
+            available = available < 0 ? groupAvailable : qMin(available, groupAvailable);
+        }
+
+        if(group.isEmpty())
+        {
+            break;
+        }
+
+        group.truncate(group.lastIndexOf(QLatin1Char('/')));
+    }
+
+    return available;
+}
+
+qint64 readCgroupAvailable()
+{
+    // unified hierarchy first, then the legacy memory controller
+
+    const QString unifiedPath = readCgroupPath(QByteArray());
+
+    if(!unifiedPath.isEmpty())
+    {
+        const qint64 available = readCgroupHierarchyAvailable(QLatin1String("/sys/fs/cgroup"), unifiedPath,
+                                                              QLatin1String("memory.max"), QLatin1String("memory.current"));
+
+        if(available >= 0)
+        {
+            return available;
+        }
+    }
+
+    const QString legacyPath = readCgroupPath("memory");
+
+    if(!legacyPath.isEmpty())
+    {
+        return readCgroupHierarchyAvailable(QLatin1String("/sys/fs/cgroup/memory"), legacyPath,
+                                            QLatin1String("memory.limit_in_bytes"), QLatin1String("memory.usage_in_bytes"));
+    }
+
+    return -1;
+}
+
+} // anonymous
+
+namespace qpdfview
+{
+
+Settings* MemoryManager::s_settings = 0;
+
+MemoryManager* MemoryManager::s_instance = 0;
+
+MemoryManager* MemoryManager::instance()
+{
+    if(s_instance == 0)
+    {
+        s_instance = new MemoryManager(qApp);
+    }
+
+    return s_instance;
+}
+
+MemoryManager::~MemoryManager()
+{
+    s_instance = 0;
+}
+
+void MemoryManager::registerView()
+{
+    ++m_views;
+
+    update();
+}
+
+void MemoryManager::unregisterView()
+{
+    --m_views;
+
+    update();
+}
+
+void MemoryManager::update()
+{
+    const int cacheSize = s_settings->pageItem().cacheSize();
+
+    qint64 size = cacheSize;
+
+    if(cacheSize < 0)
+    {
+        // the memory held by the caches themselves is available to them, as filling them up would otherwise shrink them
+
+        qint64 available = availableMemory();
+
+        if(available >= 0)
+        {
+            available += qint64(m_tileBudget) + qint64(m_thumbnailBudget) + qint64(m_obsoletePixmapBudget);
+        }
+
+        // every open document is expected to need about as much memory as the shared caches,
+        // so they get a quarter of it with a single view, a fifth with two views and so on
+
+        const qint64 share = available / (3 + qMax(m_views, 1));
+
+        size = available >= 0 ? qBound(minimumAutomaticSize, share, maximumAutomaticSize) : fallbackAutomaticSize;
+    }
+
+    const int tileBudget = size / 8 * 6;
+    const int thumbnailBudget = size / 8;
+    const int obsoletePixmapBudget = size / 8;
+
+    if(m_tileBudget != tileBudget || m_thumbnailBudget != thumbnailBudget || m_obsoletePixmapBudget != obsoletePixmapBudget)
+    {
+        m_tileBudget = tileBudget;
+        m_thumbnailBudget = thumbnailBudget;
+        m_obsoletePixmapBudget = obsoletePixmapBudget;
+
+        emit budgetsChanged();
+    }
+
+    if(cacheSize < 0 && m_views > 0)
+    {
+        m_updateTimer->start();
+    }
+    else
+    {
+        m_updateTimer->stop();
+    }
+}
+
+MemoryManager::MemoryManager(QObject* parent) : QObject(parent),
+    m_updateTimer(0),
+    m_views(0),
+    m_tileBudget(0),
+    m_thumbnailBudget(0),
+    m_obsoletePixmapBudget(0)
+{
+    if(s_settings == 0)
+    {
+        s_settings = Settings::instance();
+    }
+
+    m_updateTimer = new QTimer(this);
+    m_updateTimer->setInterval(updateInterval);
+
+    connect(m_updateTimer, SIGNAL(timeout()), SLOT(update()));
+
+    update();
+}
+
+qint64 MemoryManager::availableMemory()
+{
+    qint64 available = -1;
+
+#ifdef Q_OS_LINUX
+
+    available = readMemoryAvailable();
+
+    const qint64 cgroupAvailable = readCgroupAvailable();
+
+    if(cgroupAvailable >= 0 && (available < 0 || cgroupAvailable < available))
+    {
+        available = cgroupAvailable;
+    }
+
+#endif // Q_OS_LINUX
+
+    return available;
+}
+
+} // qpdfview
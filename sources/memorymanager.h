@@ -0,0 +1,78 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef MEMORYMANAGER_H
+#define MEMORYMANAGER_H
+
+#include <QObject>
+
+class QTimer;
+
+namespace qpdfview
+{
+
+class Settings;
+
+class MemoryManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MemoryManager* instance();
+    ~MemoryManager();
+
+    inline int tileBudget() const { return m_tileBudget; }
+    inline int thumbnailBudget() const { return m_thumbnailBudget; }
+    inline int obsoletePixmapBudget() const { return m_obsoletePixmapBudget; }
+
+    void registerView();
+    void unregisterView();
+
+signals:
+    void budgetsChanged();
+
+public slots:
+    void update();
+
+private:
+    Q_DISABLE_COPY(MemoryManager)
+
+    static MemoryManager* s_instance;
+    MemoryManager(QObject* parent = 0);
+
+    static Settings* s_settings;
+
+    static qint64 availableMemory();
+
+    QTimer* m_updateTimer;
+
+    int m_views;
+
+    int m_tileBudget;
+    int m_thumbnailBudget;
+    int m_obsoletePixmapBudget;
+
+};
+
+} // qpdfview
+
+#endif // MEMORYMANAGER_H
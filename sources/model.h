@@ -110,6 +110,8 @@ namespace Model
 
         virtual QImage render(qreal horizontalResolution = 72.0, qreal verticalResolution = 72.0, Rotation rotation = RotateBy0, const QRect& boundingRect = QRect()) const = 0;
 
+        virtual QImage thumbnail() const { return QImage(); }
+
         virtual QString label() const { return QString(); }
 
         virtual QList< Link* > links() const { return QList< Link* >(); }
@@ -149,6 +151,8 @@ namespace Model
 
         virtual void setPaperColor(const QColor& paperColor) { Q_UNUSED(paperColor); }
 
+        virtual QByteArray renderKey() const { return QByteArray(); }
+
         virtual void loadOutline(QStandardItemModel* outlineModel) const { outlineModel->clear(); }
         virtual void loadProperties(QStandardItemModel* propertiesModel) const { propertiesModel->clear(); }
 
@@ -32,9 +32,9 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMessageBox>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
-#include <QTimer>
 #include <QToolTip>
 #include <QUrl>
+#include <QtConcurrentRun>
 
 #include "settings.h"
 #include "model.h"
@@ -70,6 +70,8 @@ PageItem::PageItem(Model::Page* page, int index, DrawMode drawMode, QGraphicsIte
     m_links(),
     m_annotations(),
     m_formFields(),
+    m_interactiveElementsWatcher(0),
+    m_interactiveElementsLoaded(false),
     m_rubberBandMode(ModifiersMode),
     m_rubberBand(),
     m_annotationOverlay(),
@@ -78,7 +80,10 @@ PageItem::PageItem(Model::Page* page, int index, DrawMode drawMode, QGraphicsIte
     m_transform(),
     m_normalizedTransform(),
     m_boundingRect(),
-    m_tileItems()
+    m_tileItems(),
+    m_tilingIsPrepared(false),
+    m_renderScheduler(0),
+    m_diskCacheKey()
 {
     if(s_settings == 0)
     {
@@ -100,8 +105,6 @@ PageItem::PageItem(Model::Page* page, int index, DrawMode drawMode, QGraphicsIte
         m_tileItems.replace(0, tile);
     }
 
-    QTimer::singleShot(0, this, SLOT(loadInteractiveElements()));
-
     prepareGeometry();
 }
 
@@ -112,6 +115,17 @@ PageItem::~PageItem()
 
     TileItem::dropCachedPixmaps(this);
 
+    if(m_interactiveElementsWatcher != 0)
+    {
+        m_interactiveElementsWatcher->waitForFinished();
+
+        const InteractiveElements interactiveElements = m_interactiveElementsWatcher->result();
+
+        qDeleteAll(interactiveElements.links);
+        qDeleteAll(interactiveElements.annotations);
+        qDeleteAll(interactiveElements.formFields);
+    }
+
     qDeleteAll(m_links);
     qDeleteAll(m_annotations);
     qDeleteAll(m_formFields);
@@ -136,6 +150,13 @@ QRectF PageItem::boundingRect() const
 
 void PageItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*)
 {
+    prepareInteractiveElements();
+
+    if(!m_tilingIsPrepared)
+    {
+        prepareTiling();
+    }
+
     paintPage(painter, option->exposedRect);
 
     paintLinks(painter);
@@ -147,35 +168,30 @@ void PageItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
 
 qreal PageItem::displayedWidth() const
 {
-    const qreal cropWidth = m_cropRect.isNull() ? 1.0 : m_cropRect.width();
-    const qreal cropHeight = m_cropRect.isNull() ? 1.0 : m_cropRect.height();
-
-    switch(m_renderParam.rotation)
-    {
-    default:
-    case RotateBy0:
-    case RotateBy180:
-        return m_renderParam.resolution.resolutionX / 72.0 * cropWidth * m_size.width();
-    case RotateBy90:
-    case RotateBy270:
-        return m_renderParam.resolution.resolutionX / 72.0 * cropHeight * m_size.height();
-    }
+    return displayedSize(m_renderParam.resolution, m_renderParam.rotation).width();
 }
 
 qreal PageItem::displayedHeight() const
 {
-    const qreal cropHeight = m_cropRect.isNull() ? 1.0 : m_cropRect.height();
+    return displayedSize(m_renderParam.resolution, m_renderParam.rotation).height();
+}
+
+QSizeF PageItem::displayedSize(const RenderResolution& resolution, Rotation rotation) const
+{
     const qreal cropWidth = m_cropRect.isNull() ? 1.0 : m_cropRect.width();
+    const qreal cropHeight = m_cropRect.isNull() ? 1.0 : m_cropRect.height();
 
-    switch(m_renderParam.rotation)
+    switch(rotation)
     {
     default:
     case RotateBy0:
     case RotateBy180:
-        return m_renderParam.resolution.resolutionY / 72.0 * cropHeight * m_size.height();
+        return QSizeF(resolution.resolutionX / 72.0 * cropWidth * m_size.width(),
+                      resolution.resolutionY / 72.0 * cropHeight * m_size.height());
     case RotateBy90:
     case RotateBy270:
-        return m_renderParam.resolution.resolutionY / 72.0 * cropWidth * m_size.width();
+        return QSizeF(resolution.resolutionX / 72.0 * cropHeight * m_size.height(),
+                      resolution.resolutionY / 72.0 * cropWidth * m_size.width());
     }
 }
 
@@ -281,6 +297,18 @@ void PageItem::setConvertToGrayscale(bool convertToGrayscale)
     }
 }
 
+void PageItem::setDocumentKey(const QByteArray& documentKey)
+{
+    if(documentKey.isEmpty())
+    {
+        m_diskCacheKey = QByteArray();
+    }
+    else
+    {
+        m_diskCacheKey = documentKey + '\0' + QByteArray::number(m_index);
+    }
+}
+
 
 void PageItem::refresh(bool keepObsoletePixmaps, bool dropCachedPixmaps)
 {
@@ -311,6 +339,11 @@ void PageItem::refresh(bool keepObsoletePixmaps, bool dropCachedPixmaps)
 
 int PageItem::startRender(bool prefetch)
 {
+    if(!m_tilingIsPrepared)
+    {
+        prepareTiling();
+    }
+
     int cost = 0;
 
     if(!s_settings->pageItem().useTiling() || thumbnailMode())
@@ -328,17 +361,17 @@ int PageItem::startRender(bool prefetch)
     return cost;
 }
 
-void PageItem::cancelRender()
+void PageItem::cancelRender(bool force)
 {
     if(!s_settings->pageItem().useTiling() || thumbnailMode())
     {
-        m_tileItems.first()->cancelRender();
+        m_tileItems.first()->cancelRender(force);
     }
     else
     {
         foreach(TileItem* tile, m_tileItems)
         {
-            tile->cancelRender();
+            tile->cancelRender(force);
         }
     }
 }
@@ -701,28 +734,102 @@ void PageItem::contextMenuEvent(QGraphicsSceneContextMenuEvent* event)
     event->ignore();
 }
 
-void PageItem::loadInteractiveElements()
+void PageItem::prepareInteractiveElements()
 {
-    m_links = m_page->links();
+    if(m_interactiveElementsLoaded || m_interactiveElementsWatcher != 0 || thumbnailMode())
+    {
+        return;
+    }
+
+    m_interactiveElementsWatcher = new InteractiveElementsWatcher(this);
+    connect(m_interactiveElementsWatcher, SIGNAL(finished()), SLOT(on_loadInteractiveElements_finished()));
 
-    if(!presentationMode())
+    m_interactiveElementsWatcher->setFuture(QtConcurrent::run(loadInteractiveElements, m_page, !presentationMode(), thread()));
+}
+
+void PageItem::waitForInteractiveElements()
+{
+    prepareInteractiveElements();
+
+    if(m_interactiveElementsWatcher != 0)
     {
-        m_annotations = m_page->annotations();
+        m_interactiveElementsWatcher->disconnect(this);
+        m_interactiveElementsWatcher->waitForFinished();
 
-        foreach(const Model::Annotation* annotation, m_annotations)
+        on_loadInteractiveElements_finished();
+    }
+}
+
+void PageItem::dropInteractiveElements()
+{
+    if(!m_interactiveElementsLoaded || !m_annotationOverlay.isEmpty() || !m_formFieldOverlay.isEmpty())
+    {
+        return;
+    }
+
+    qDeleteAll(m_links);
+    qDeleteAll(m_annotations);
+    qDeleteAll(m_formFields);
+
+    m_links.clear();
+    m_annotations.clear();
+    m_formFields.clear();
+
+    m_interactiveElementsLoaded = false;
+}
+
+void PageItem::on_loadInteractiveElements_finished()
+{
+    const InteractiveElements interactiveElements = m_interactiveElementsWatcher->result();
+
+    m_interactiveElementsWatcher->deleteLater();
+    m_interactiveElementsWatcher = 0;
+
+    m_links = interactiveElements.links;
+    m_annotations = interactiveElements.annotations;
+    m_formFields = interactiveElements.formFields;
+
+    foreach(const Model::Annotation* annotation, m_annotations)
+    {
+        connect(annotation, SIGNAL(wasModified()), SIGNAL(wasModified()));
+    }
+
+    foreach(const Model::FormField* formField, m_formFields)
+    {
+        connect(formField, SIGNAL(wasModified()), SIGNAL(wasModified()));
+    }
+
+    m_interactiveElementsLoaded = true;
+
+    update();
+}
+
+PageItem::InteractiveElements PageItem::loadInteractiveElements(Model::Page* page, bool annotationsAndFormFields, QThread* thread)
+{
+    InteractiveElements interactiveElements;
+
+    interactiveElements.links = page->links();
+
+    if(annotationsAndFormFields)
+    {
+        // annotations and form fields are created on the worker thread but used on the thread of the page item
+
+        interactiveElements.annotations = page->annotations();
+
+        foreach(Model::Annotation* annotation, interactiveElements.annotations)
         {
-            connect(annotation, SIGNAL(wasModified()), SIGNAL(wasModified()));
+            annotation->moveToThread(thread);
         }
 
-        m_formFields = m_page->formFields();
+        interactiveElements.formFields = page->formFields();
 
-        foreach(const Model::FormField* formField, m_formFields)
+        foreach(Model::FormField* formField, interactiveElements.formFields)
         {
-            connect(formField, SIGNAL(wasModified()), SIGNAL(wasModified()));
+            formField->moveToThread(thread);
         }
     }
 
-    update();
+    return interactiveElements;
 }
 
 void PageItem::updateCropRect()
@@ -830,6 +937,10 @@ void PageItem::addAnnotation(const QPoint& screenPos)
 
         if(action == addTextAction || action == addHighlightAction)
         {
+            // the loaded annotations would replace the added one otherwise
+
+            waitForInteractiveElements();
+
             QRectF boundary = m_normalizedTransform.inverted().mapRect(m_rubberBand);
 
             Model::Annotation* annotation = 0;
@@ -1075,7 +1186,9 @@ void PageItem::prepareGeometry()
     m_boundingRect.setHeight(qRound(m_boundingRect.height()));
 
 
-    prepareTiling();
+    // tiling is deferred until the page is painted or rendered so that relayouting large documents stays cheap
+
+    m_tilingIsPrepared = false;
 
     updateAnnotationOverlay();
     updateFormFieldOverlay();
@@ -1083,6 +1196,8 @@ void PageItem::prepareGeometry()
 
 void PageItem::prepareTiling()
 {
+    m_tilingIsPrepared = true;
+
     if(!s_settings->pageItem().useTiling() || thumbnailMode())
     {
         m_tileItems.first()->setRect(QRect(0, 0, m_boundingRect.width(), m_boundingRect.height()));
@@ -23,10 +23,12 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #define PAGEITEM_H
 
 #include <QCache>
+#include <QFutureWatcher>
 #include <QGraphicsObject>
 #include <QIcon>
 
 class QGraphicsProxyWidget;
+class QThread;
 
 #include "global.h"
 
@@ -42,6 +44,7 @@ class Page;
 }
 
 class Settings;
+class RenderScheduler;
 class RenderTask;
 class TileItem;
 
@@ -72,6 +75,8 @@ public:
     qreal displayedWidth() const;
     qreal displayedHeight() const;
 
+    QSizeF displayedSize(const RenderResolution& resolution, Rotation rotation) const;
+
     inline const QList< QRectF >& highlights() const { return m_highlights; }
     void setHighlights(const QList< QRectF >& highlights);
 
@@ -103,6 +108,15 @@ public:
     inline const QTransform& transform() const { return m_transform; }
     inline const QTransform& normalizedTransform() const { return m_normalizedTransform; }
 
+    inline RenderScheduler* renderScheduler() const { return m_renderScheduler; }
+    inline void setRenderScheduler(RenderScheduler* renderScheduler) { m_renderScheduler = renderScheduler; }
+
+    void setDocumentKey(const QByteArray& documentKey);
+
+    void prepareInteractiveElements();
+    void waitForInteractiveElements();
+    void dropInteractiveElements();
+
 signals:
     void cropRectChanged();
 
@@ -122,7 +136,7 @@ public slots:
     void refresh(bool keepObsoletePixmaps = false, bool dropCachedPixmaps = false);
 
     int startRender(bool prefetch = false);
-    void cancelRender();
+    void cancelRender(bool force = false);
 
 protected slots:
     void showAnnotationOverlay(Model::Annotation* selectedAnnotation);
@@ -146,7 +160,7 @@ protected:
     void contextMenuEvent(QGraphicsSceneContextMenuEvent* event);
 
 private slots:
-    virtual void loadInteractiveElements();
+    void on_loadInteractiveElements_finished();
 
 private:
     Q_DISABLE_COPY(PageItem)
@@ -174,6 +188,20 @@ private:
     QList< Model::Annotation* > m_annotations;
     QList< Model::FormField* > m_formFields;
 
+    struct InteractiveElements
+    {
+        QList< Model::Link* > links;
+        QList< Model::Annotation* > annotations;
+        QList< Model::FormField* > formFields;
+    };
+
+    static InteractiveElements loadInteractiveElements(Model::Page* page, bool annotationsAndFormFields, QThread* thread);
+
+    typedef QFutureWatcher< InteractiveElements > InteractiveElementsWatcher;
+    InteractiveElementsWatcher* m_interactiveElementsWatcher;
+
+    bool m_interactiveElementsLoaded;
+
     RubberBandMode m_rubberBandMode;
     QRectF m_rubberBand;
 
@@ -210,9 +238,14 @@ private:
     void prepareGeometry();
 
     QVector< TileItem* > m_tileItems;
+    bool m_tilingIsPrepared;
 
     void prepareTiling();
 
+    RenderScheduler* m_renderScheduler;
+
+    QByteArray m_diskCacheKey;
+
     // paint
 
     void paintPage(QPainter* painter, const QRectF& exposedRect) const;
@@ -22,9 +22,11 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "pdfmodel.h"
 
+#include <QFileInfo>
 #include <QFormLayout>
 #include <QMessageBox>
 #include <QSettings>
+#include <QSpinBox>
 
 #if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
 
@@ -48,6 +50,8 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #define LOCK_PAGE QMutexLocker mutexLocker(m_mutex);
 #define LOCK_DOCUMENT QMutexLocker mutexLocker(&m_mutex);
 
+#define INVALIDATE_RENDER_POOL m_renderPool->invalidate();
+
 #else
 
 #define LOCK_ANNOTATION
@@ -55,6 +59,8 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #define LOCK_PAGE
 #define LOCK_DOCUMENT
 
+#define INVALIDATE_RENDER_POOL
+
 #endif // HAS_POPPLER_24
 
 namespace
@@ -142,8 +148,159 @@ namespace qpdfview
 namespace Model
 {
 
-PdfAnnotation::PdfAnnotation(QMutex* mutex, Poppler::Annotation* annotation) : Annotation(),
+#ifndef HAS_POPPLER_24
+
+PdfRenderPool::PdfRenderPool(const Poppler::Document* prototype, const QString& filePath, int maximumCount) :
+    m_mutex(),
+    m_filePath(filePath),
+    m_lastModified(QFileInfo(filePath).lastModified()),
+    m_size(QFileInfo(filePath).size()),
+    m_password(),
+    m_renderHints(prototype->renderHints()),
+    m_renderBackend(prototype->renderBackend()),
+    m_paperColor(prototype->paperColor()),
+    m_maximumCount(maximumCount),
+    m_count(0),
+    m_invalidated(false),
+    m_documents()
+{
+}
+
+PdfRenderPool::~PdfRenderPool()
+{
+    qDeleteAll(m_documents);
+}
+
+Poppler::Document* PdfRenderPool::acquire()
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    if(m_invalidated)
+    {
+        return 0;
+    }
+
+    const QColor paperColor = m_paperColor;
+
+    if(!m_documents.isEmpty())
+    {
+        Poppler::Document* document = m_documents.takeLast();
+
+        mutexLocker.unlock();
+
+        document->setPaperColor(paperColor);
+
+        return document;
+    }
+
+    if(m_count >= m_maximumCount)
+    {
+        return 0;
+    }
+
+    // loading is expensive, so reserve a slot and load without holding the lock
+
+    ++m_count;
+
+    const QString filePath = m_filePath;
+    const QByteArray password = m_password;
+
+    mutexLocker.unlock();
+
+    // copies must show the same content as the main document, so nothing is loaded once the file changed on disk
+
+    Poppler::Document* document = fileWasChanged() ? 0 : Poppler::Document::load(filePath, password, password);
+
+    if(document != 0 && (document->isLocked() || fileWasChanged()))
+    {
+        delete document;
+        document = 0;
+    }
+
+    if(document == 0)
+    {
+        mutexLocker.relock();
+
+        --m_count;
+
+        return 0;
+    }
+
+    // copy the render hints of the main document bit by bit since there is no bulk setter
+
+    for(int bit = 0; bit < 16; ++bit)
+    {
+        const Poppler::Document::RenderHint renderHint = static_cast< Poppler::Document::RenderHint >(1 << bit);
+
+        document->setRenderHint(renderHint, (m_renderHints & renderHint) != 0);
+    }
+
+    document->setRenderBackend(static_cast< Poppler::Document::RenderBackend >(m_renderBackend));
+    document->setPaperColor(paperColor);
+
+    return document;
+}
+
+void PdfRenderPool::release(Poppler::Document* document)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    if(m_invalidated)
+    {
+        --m_count;
+
+        delete document;
+        return;
+    }
+
+    m_documents.append(document);
+}
+
+void PdfRenderPool::setPassword(const QByteArray& password)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    m_password = password;
+}
+
+void PdfRenderPool::setPaperColor(const QColor& paperColor)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    m_paperColor = paperColor;
+}
+
+void PdfRenderPool::invalidate()
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    if(m_invalidated)
+    {
+        return;
+    }
+
+    // modifications are only applied to the main document, so stop rendering from copies
+
+    m_invalidated = true;
+
+    m_count -= m_documents.count();
+
+    qDeleteAll(m_documents);
+    m_documents.clear();
+}
+
+bool PdfRenderPool::fileWasChanged() const
+{
+    const QFileInfo fileInfo(m_filePath);
+
+    return fileInfo.lastModified() != m_lastModified || fileInfo.size() != m_size;
+}
+
+#endif // HAS_POPPLER_24
+
+PdfAnnotation::PdfAnnotation(QMutex* mutex, PdfRenderPool* renderPool, Poppler::Annotation* annotation) : Annotation(),
     m_mutex(mutex),
+    m_renderPool(renderPool),
     m_annotation(annotation)
 {
 }
@@ -169,6 +326,8 @@ QString PdfAnnotation::contents() const
 
 QWidget* PdfAnnotation::createWidget()
 {
+    INVALIDATE_RENDER_POOL
+
     QWidget* widget = 0;
 
     if(m_annotation->subType() == Poppler::Annotation::AText || m_annotation->subType() == Poppler::Annotation::AHighlight)
@@ -187,8 +346,9 @@ QWidget* PdfAnnotation::createWidget()
     return widget;
 }
 
-PdfFormField::PdfFormField(QMutex* mutex, Poppler::FormField* formField) : FormField(),
+PdfFormField::PdfFormField(QMutex* mutex, PdfRenderPool* renderPool, Poppler::FormField* formField) : FormField(),
     m_mutex(mutex),
+    m_renderPool(renderPool),
     m_formField(formField)
 {
 }
@@ -214,6 +374,8 @@ QString PdfFormField::name() const
 
 QWidget* PdfFormField::createWidget()
 {
+    INVALIDATE_RENDER_POOL
+
     QWidget* widget = 0;
 
     if(m_formField->type() == Poppler::FormField::FormText)
@@ -261,9 +423,11 @@ QWidget* PdfFormField::createWidget()
     return widget;
 }
 
-PdfPage::PdfPage(QMutex* mutex, Poppler::Page* page) :
+PdfPage::PdfPage(QMutex* mutex, PdfRenderPool* renderPool, Poppler::Page* page, int index) :
     m_mutex(mutex),
-    m_page(page)
+    m_renderPool(renderPool),
+    m_page(page),
+    m_index(index)
 {
 }
 
@@ -281,8 +445,6 @@ QSizeF PdfPage::size() const
 
 QImage PdfPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, const QRect& boundingRect) const
 {
-    LOCK_PAGE
-
     Poppler::Page::Rotation rotate;
 
     switch(rotation)
@@ -315,9 +477,40 @@ QImage PdfPage::render(qreal horizontalResolution, qreal verticalResolution, Rot
         h = boundingRect.height();
     }
 
+#ifndef HAS_POPPLER_24
+
+    Poppler::Document* document = m_renderPool->acquire();
+
+    if(document != 0)
+    {
+        QScopedPointer< Poppler::Page > page(document->page(m_index));
+
+        if(!page.isNull())
+        {
+            const QImage image = page->renderToImage(horizontalResolution, verticalResolution, x, y, w, h, rotate);
+
+            m_renderPool->release(document);
+
+            return image;
+        }
+
+        m_renderPool->release(document);
+    }
+
+#endif // HAS_POPPLER_24
+
+    LOCK_PAGE
+
     return m_page->renderToImage(horizontalResolution, verticalResolution, x, y, w, h, rotate);
 }
 
+QImage PdfPage::thumbnail() const
+{
+    LOCK_PAGE
+
+    return m_page->thumbnail();
+}
+
 QString PdfPage::label() const
 {
     LOCK_PAGE
@@ -436,7 +629,7 @@ QList< Annotation* > PdfPage::annotations() const
     {
         if(annotation->subType() == Poppler::Annotation::AText || annotation->subType() == Poppler::Annotation::AHighlight || annotation->subType() == Poppler::Annotation::AFileAttachment)
         {
-            annotations.append(new PdfAnnotation(m_mutex, annotation));
+            annotations.append(new PdfAnnotation(m_mutex, m_renderPool, annotation));
             continue;
         }
 
@@ -470,6 +663,8 @@ Annotation* PdfPage::addTextAnnotation(const QRectF& boundary, const QColor& col
     Poppler::Annotation::Style style;
     style.setColor(color);
 
+    INVALIDATE_RENDER_POOL
+
     Poppler::Annotation::Popup popup;
     popup.setFlags(Poppler::Annotation::Hidden | Poppler::Annotation::ToggleHidingOnMouse);
 
@@ -481,7 +676,7 @@ Annotation* PdfPage::addTextAnnotation(const QRectF& boundary, const QColor& col
 
     m_page->addAnnotation(annotation);
 
-    return new PdfAnnotation(m_mutex, annotation);
+    return new PdfAnnotation(m_mutex, m_renderPool, annotation);
 
 #else
 
@@ -502,6 +697,8 @@ Annotation* PdfPage::addHighlightAnnotation(const QRectF& boundary, const QColor
     Poppler::Annotation::Style style;
     style.setColor(color);
 
+    INVALIDATE_RENDER_POOL
+
     Poppler::Annotation::Popup popup;
     popup.setFlags(Poppler::Annotation::Hidden | Poppler::Annotation::ToggleHidingOnMouse);
 
@@ -521,7 +718,7 @@ Annotation* PdfPage::addHighlightAnnotation(const QRectF& boundary, const QColor
 
     m_page->addAnnotation(annotation);
 
-    return new PdfAnnotation(m_mutex, annotation);
+    return new PdfAnnotation(m_mutex, m_renderPool, annotation);
 
 #else
 
@@ -540,6 +737,8 @@ void PdfPage::removeAnnotation(Annotation* annotation)
 
 #ifdef HAS_POPPLER_20
 
+    INVALIDATE_RENDER_POOL
+
     PdfAnnotation* pdfAnnotation = static_cast< PdfAnnotation* >(annotation);
 
     m_page->removeAnnotation(pdfAnnotation->m_annotation);
@@ -572,7 +771,7 @@ QList< FormField* > PdfPage::formFields() const
 
             if(formFieldText->textType() == Poppler::FormFieldText::Normal || formFieldText->textType() == Poppler::FormFieldText::Multiline)
             {
-                formFields.append(new PdfFormField(m_mutex, formField));
+                formFields.append(new PdfFormField(m_mutex, m_renderPool, formField));
                 continue;
             }
         }
@@ -582,7 +781,7 @@ QList< FormField* > PdfPage::formFields() const
 
             if(formFieldChoice->choiceType() == Poppler::FormFieldChoice::ListBox || formFieldChoice->choiceType() == Poppler::FormFieldChoice::ComboBox)
             {
-                formFields.append(new PdfFormField(m_mutex, formField));
+                formFields.append(new PdfFormField(m_mutex, m_renderPool, formField));
                 continue;
             }
         }
@@ -592,7 +791,7 @@ QList< FormField* > PdfPage::formFields() const
 
             if(formFieldButton->buttonType() == Poppler::FormFieldButton::CheckBox || formFieldButton->buttonType() == Poppler::FormFieldButton::Radio)
             {
-                formFields.append(new PdfFormField(m_mutex, formField));
+                formFields.append(new PdfFormField(m_mutex, m_renderPool, formField));
                 continue;
             }
         }
@@ -603,12 +802,27 @@ QList< FormField* > PdfPage::formFields() const
     return formFields;
 }
 
-PdfDocument::PdfDocument(Poppler::Document* document) :
+#ifndef HAS_POPPLER_24
+
+PdfDocument::PdfDocument(Poppler::Document* document, const QString& filePath, int renderWorkers) :
+    m_mutex(),
+    m_document(document),
+    m_renderPool(document, filePath, renderWorkers - 1)
+{
+}
+
+#else
+
+PdfDocument::PdfDocument(Poppler::Document* document, const QString& filePath, int renderWorkers) :
     m_mutex(),
     m_document(document)
 {
+    Q_UNUSED(filePath)
+    Q_UNUSED(renderWorkers)
 }
 
+#endif // HAS_POPPLER_24
+
 PdfDocument::~PdfDocument()
 {
     delete m_document;
@@ -627,7 +841,15 @@ Page* PdfDocument::page(int index) const
 
     Poppler::Page* page = m_document->page(index);
 
-    return page != 0 ? new PdfPage(&m_mutex, page) : 0;
+#ifndef HAS_POPPLER_24
+
+    return page != 0 ? new PdfPage(&m_mutex, &m_renderPool, page, index) : 0;
+
+#else
+
+    return page != 0 ? new PdfPage(&m_mutex, 0, page, index) : 0;
+
+#endif // HAS_POPPLER_24
 }
 
 bool PdfDocument::isLocked() const
@@ -641,6 +863,12 @@ bool PdfDocument::unlock(const QString& password)
 {
     LOCK_DOCUMENT
 
+#ifndef HAS_POPPLER_24
+
+    m_renderPool.setPassword(password.toLatin1());
+
+#endif // HAS_POPPLER_24
+
     return m_document->unlock(password.toLatin1(), password.toLatin1());
 }
 
@@ -679,9 +907,24 @@ void PdfDocument::setPaperColor(const QColor& paperColor)
 {
     LOCK_DOCUMENT
 
+#ifndef HAS_POPPLER_24
+
+    m_renderPool.setPaperColor(paperColor);
+
+#endif // HAS_POPPLER_24
+
     m_document->setPaperColor(paperColor);
 }
 
+QByteArray PdfDocument::renderKey() const
+{
+    LOCK_DOCUMENT
+
+    return QByteArray("pdf") + '\0'
+            + QByteArray::number(static_cast< int >(m_document->renderHints())) + '\0'
+            + QByteArray::number(static_cast< int >(m_document->renderBackend()));
+}
+
 void Model::PdfDocument::loadOutline(QStandardItemModel* outlineModel) const
 {
     Document::loadOutline(outlineModel);
@@ -874,6 +1117,19 @@ PdfSettingsWidget::PdfSettingsWidget(QSettings* settings, QWidget* parent) : Set
     m_backendComboBox->setCurrentIndex(m_settings->value("backend", 0).toInt());
 
     m_layout->addRow(tr("Backend:"), m_backendComboBox);
+
+#ifndef HAS_POPPLER_24
+
+    // render workers
+
+    m_renderWorkersSpinBox = new QSpinBox(this);
+    m_renderWorkersSpinBox->setRange(1, 16);
+    m_renderWorkersSpinBox->setToolTip(tr("Number of document instances used to render pages of the same document concurrently."));
+    m_renderWorkersSpinBox->setValue(m_settings->value("renderWorkers", 1).toInt());
+
+    m_layout->addRow(tr("Render workers:"), m_renderWorkersSpinBox);
+
+#endif // HAS_POPPLER_24
 }
 
 void PdfSettingsWidget::accept()
@@ -905,6 +1161,12 @@ void PdfSettingsWidget::accept()
 #endif // HAS_POPPLER_24
 
     m_settings->setValue("backend", m_backendComboBox->currentIndex());
+
+#ifndef HAS_POPPLER_24
+
+    m_settings->setValue("renderWorkers", m_renderWorkersSpinBox->value());
+
+#endif // HAS_POPPLER_24
 }
 
 void PdfSettingsWidget::reset()
@@ -935,6 +1197,12 @@ void PdfSettingsWidget::reset()
 #endif // HAS_POPPLER_24
 
     m_backendComboBox->setCurrentIndex(0);
+
+#ifndef HAS_POPPLER_24
+
+    m_renderWorkersSpinBox->setValue(1);
+
+#endif // HAS_POPPLER_24
 }
 
 PdfPlugin::PdfPlugin(QObject* parent) : QObject(parent)
@@ -1016,7 +1284,7 @@ Model::Document* PdfPlugin::loadDocument(const QString& filePath) const
         }
     }
 
-    return document != 0 ? new Model::PdfDocument(document) : 0;
+    return document != 0 ? new Model::PdfDocument(document, filePath, m_settings->value("renderWorkers", 1).toInt()) : 0;
 }
 
 SettingsWidget* PdfPlugin::createSettingsWidget(QWidget* parent) const
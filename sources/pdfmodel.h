@@ -23,7 +23,9 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PDFMODEL_H
 #define PDFMODEL_H
 
+#include <QColor>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QMutex>
 #include <QScopedPointer>
 
@@ -31,6 +33,7 @@ class QCheckBox;
 class QComboBox;
 class QFormLayout;
 class QSettings;
+class QSpinBox;
 
 namespace Poppler
 {
@@ -49,6 +52,51 @@ class PdfPlugin;
 
 namespace Model
 {
+    class PdfRenderPool;
+
+#ifndef HAS_POPPLER_24
+
+    class PdfRenderPool
+    {
+    public:
+        PdfRenderPool(const Poppler::Document* prototype, const QString& filePath, int maximumCount);
+        ~PdfRenderPool();
+
+        Poppler::Document* acquire();
+        void release(Poppler::Document* document);
+
+        void setPassword(const QByteArray& password);
+        void setPaperColor(const QColor& paperColor);
+
+        void invalidate();
+
+    private:
+        Q_DISABLE_COPY(PdfRenderPool)
+
+        QMutex m_mutex;
+
+        QString m_filePath;
+        QDateTime m_lastModified;
+        qint64 m_size;
+
+        QByteArray m_password;
+
+        int m_renderHints;
+        int m_renderBackend;
+        QColor m_paperColor;
+
+        int m_maximumCount;
+        int m_count;
+        bool m_invalidated;
+
+        QList< Poppler::Document* > m_documents;
+
+        bool fileWasChanged() const;
+
+    };
+
+#endif // HAS_POPPLER_24
+
     class PdfAnnotation : public Annotation
     {
         Q_OBJECT
@@ -66,9 +114,10 @@ namespace Model
     private:
         Q_DISABLE_COPY(PdfAnnotation)
 
-        PdfAnnotation(QMutex* mutex, Poppler::Annotation* annotation);
+        PdfAnnotation(QMutex* mutex, PdfRenderPool* renderPool, Poppler::Annotation* annotation);
 
         mutable QMutex* m_mutex;
+        PdfRenderPool* m_renderPool;
         Poppler::Annotation* m_annotation;
 
     };
@@ -90,9 +139,10 @@ namespace Model
     private:
         Q_DISABLE_COPY(PdfFormField)
 
-        PdfFormField(QMutex* mutex, Poppler::FormField* formField);
+        PdfFormField(QMutex* mutex, PdfRenderPool* renderPool, Poppler::FormField* formField);
 
         mutable QMutex* m_mutex;
+        PdfRenderPool* m_renderPool;
         Poppler::FormField* m_formField;
 
     };
@@ -110,6 +160,8 @@ namespace Model
 
         QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, const QRect& boundingRect) const;
 
+        QImage thumbnail() const;
+
         QString label() const;
 
         QList< Link* > links() const;
@@ -129,10 +181,12 @@ namespace Model
     private:
         Q_DISABLE_COPY(PdfPage)
 
-        PdfPage(QMutex* mutex, Poppler::Page* page);
+        PdfPage(QMutex* mutex, PdfRenderPool* renderPool, Poppler::Page* page, int index);
 
         mutable QMutex* m_mutex;
+        PdfRenderPool* m_renderPool;
         Poppler::Page* m_page;
+        int m_index;
 
     };
 
@@ -161,6 +215,8 @@ namespace Model
 
         void setPaperColor(const QColor& paperColor);
 
+        QByteArray renderKey() const;
+
         void loadOutline(QStandardItemModel* outlineModel) const;
         void loadProperties(QStandardItemModel* propertiesModel) const;
 
@@ -175,11 +231,17 @@ namespace Model
     private:
         Q_DISABLE_COPY(PdfDocument)
 
-        PdfDocument(Poppler::Document* document);
+        PdfDocument(Poppler::Document* document, const QString& filePath, int renderWorkers);
 
         mutable QMutex m_mutex;
         Poppler::Document* m_document;
 
+#ifndef HAS_POPPLER_24
+
+        mutable PdfRenderPool m_renderPool;
+
+#endif // HAS_POPPLER_24
+
     };
 }
 
@@ -227,6 +289,12 @@ private:
 
     QComboBox* m_backendComboBox;
 
+#ifndef HAS_POPPLER_24
+
+    QSpinBox* m_renderWorkersSpinBox;
+
+#endif // HAS_POPPLER_24
+
 };
 
 class PdfPlugin : public QObject, Plugin
@@ -206,7 +206,7 @@ PluginHandler::~PluginHandler()
     s_instance = 0;
 }
 
-Model::Document* PluginHandler::loadDocument(const QString& filePath)
+Plugin* PluginHandler::findPlugin(const QString& filePath)
 {
     FileType fileType = matchFileType(filePath);
 
@@ -219,7 +219,7 @@ Model::Document* PluginHandler::loadDocument(const QString& filePath)
 
     if(loadPlugin(fileType))
     {
-        return m_plugins.value(fileType)->loadDocument(filePath);
+        return m_plugins.value(fileType);
     }
 
     QMessageBox::critical(0, tr("Critical"), tr("Could not load plug-in for file type '%1'!").arg(fileTypeName(fileType)));
@@ -227,6 +227,13 @@ Model::Document* PluginHandler::loadDocument(const QString& filePath)
     return 0;
 }
 
+Model::Document* PluginHandler::loadDocument(const QString& filePath)
+{
+    Plugin* plugin = findPlugin(filePath);
+
+    return plugin != 0 ? plugin->loadDocument(filePath) : 0;
+}
+
 SettingsWidget* PluginHandler::createSettingsWidget(FileType fileType, QWidget* parent)
 {
     return loadPlugin(fileType) ? m_plugins.value(fileType)->createSettingsWidget(parent) : 0;
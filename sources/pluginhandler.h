@@ -71,6 +71,8 @@ public:
         }
     }
 
+    Plugin* findPlugin(const QString& filePath);
+
     Model::Document* loadDocument(const QString& filePath);
 
     SettingsWidget* createSettingsWidget(FileType fileType, QWidget* parent = 0);
@@ -36,10 +36,10 @@ namespace qpdfview
 namespace Model
 {
 
-PsPage::PsPage(QMutex* mutex, SpectrePage* page, SpectreRenderContext* renderContext) :
-    m_mutex(mutex),
-    m_page(page),
-    m_renderContext(renderContext)
+PsPage::PsPage(const PsDocument* parent, int index, SpectrePage* page) :
+    m_parent(parent),
+    m_index(index),
+    m_page(page)
 {
 }
 
@@ -51,7 +51,7 @@ PsPage::~PsPage()
 
 QSizeF PsPage::size() const
 {
-    QMutexLocker mutexLocker(m_mutex);
+    QMutexLocker mutexLocker(&m_parent->m_mutex);
 
     int w;
     int h;
@@ -63,7 +63,7 @@ QSizeF PsPage::size() const
 
 QImage PsPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, const QRect& boundingRect) const
 {
-    QMutexLocker mutexLocker(m_mutex);
+    QMutexLocker mutexLocker(&m_parent->m_mutex);
 
     double xscale;
     double yscale;
@@ -83,25 +83,6 @@ QImage PsPage::render(qreal horizontalResolution, qreal verticalResolution, Rota
         break;
     }
 
-    spectre_render_context_set_scale(m_renderContext, xscale, yscale);
-
-    switch(rotation)
-    {
-    default:
-    case RotateBy0:
-        spectre_render_context_set_rotation(m_renderContext, 0);
-        break;
-    case RotateBy90:
-        spectre_render_context_set_rotation(m_renderContext, 90);
-        break;
-    case RotateBy180:
-        spectre_render_context_set_rotation(m_renderContext, 180);
-        break;
-    case RotateBy270:
-        spectre_render_context_set_rotation(m_renderContext, 270);
-        break;
-    }
-
     int w;
     int h;
 
@@ -115,39 +96,133 @@ QImage PsPage::render(qreal horizontalResolution, qreal verticalResolution, Rota
         qSwap(w, h);
     }
 
-    unsigned char* pageData = 0;
-    int rowLength = 0;
+    // the whole page is rasterized in any case, so tiles are cut from a shared raster unless the whole page is requested
 
-    spectre_page_render(m_page, m_renderContext, &pageData, &rowLength);
+    const PsDocument::RasterKey key(m_index, rotation, w, h);
+    const bool shareRaster = !boundingRect.isNull() && boundingRect != QRect(0, 0, w, h);
 
-    if (spectre_page_status(m_page) != SPECTRE_STATUS_SUCCESS)
+    if(shareRaster)
     {
-        free(pageData);
-        pageData = 0;
+        while(true)
+        {
+            if(const QImage* raster = m_parent->m_rasterCache.object(key))
+            {
+                return raster->copy(boundingRect);
+            }
+
+            if(!m_parent->m_pendingRasters.contains(key))
+            {
+                break;
+            }
+
+            m_parent->m_condition.wait(&m_parent->m_mutex);
+        }
+
+        m_parent->m_pendingRasters.insert(key);
+    }
 
-        return QImage();
+    PsDocument::RenderWorker* renderWorker = m_parent->acquireRenderWorker();
+
+    mutexLocker.unlock();
+
+    QImage raster;
+
+    if(renderWorker != 0)
+    {
+        SpectrePage* page = spectre_document_get_page(renderWorker->document, m_index);
+
+        if(page != 0)
+        {
+            SpectreRenderContext* renderContext = renderWorker->renderContext;
+
+            spectre_render_context_set_scale(renderContext, xscale, yscale);
+
+            switch(rotation)
+            {
+            default:
+            case RotateBy0:
+                spectre_render_context_set_rotation(renderContext, 0);
+                break;
+            case RotateBy90:
+                spectre_render_context_set_rotation(renderContext, 90);
+                break;
+            case RotateBy180:
+                spectre_render_context_set_rotation(renderContext, 180);
+                break;
+            case RotateBy270:
+                spectre_render_context_set_rotation(renderContext, 270);
+                break;
+            }
+
+            unsigned char* pageData = 0;
+            int rowLength = 0;
+
+            spectre_page_render(page, renderContext, &pageData, &rowLength);
+
+            if (spectre_page_status(page) == SPECTRE_STATUS_SUCCESS)
+            {
+                QImage auxiliaryImage(pageData, rowLength / 4, h, QImage::Format_RGB32);
+                raster = auxiliaryImage.copy(0, 0, w, h);
+            }
+
+            free(pageData);
+            pageData = 0;
+
+            spectre_page_free(page);
+        }
     }
 
-    QImage auxiliaryImage(pageData, rowLength / 4, h, QImage::Format_RGB32);
-    QImage image(boundingRect.isNull() ? auxiliaryImage.copy(0, 0, w, h) : auxiliaryImage.copy(boundingRect));
+    mutexLocker.relock();
 
-    free(pageData);
-    pageData = 0;
+    m_parent->releaseRenderWorker(renderWorker);
 
-    return image;
+    if(shareRaster)
+    {
+        m_parent->m_pendingRasters.remove(key);
+
+        if(!raster.isNull())
+        {
+            // the most recent raster is kept even if it exceeds the cache size as the remaining tiles will be cut from it
+
+            const int cost = qMax(1, raster.byteCount() / 1024);
+
+            m_parent->m_rasterCache.setMaxCost(qMax(m_parent->m_rasterCacheSize, cost));
+            m_parent->m_rasterCache.insert(key, new QImage(raster), cost);
+        }
+
+        m_parent->m_condition.wakeAll();
+
+        return raster.isNull() ? raster : raster.copy(boundingRect);
+    }
+
+    return raster;
 }
 
-PsDocument::PsDocument(SpectreDocument* document, SpectreRenderContext* renderContext) :
+PsDocument::PsDocument(const QString& filePath, SpectreDocument* document, int graphicsAntialiasBits, int textAntialiasBits, int rasterCacheSize, int maximumRenderWorkers) :
     m_mutex(),
+    m_condition(),
+    m_filePath(filePath),
     m_document(document),
-    m_renderContext(renderContext)
+    m_graphicsAntialiasBits(graphicsAntialiasBits),
+    m_textAntialiasBits(textAntialiasBits),
+    m_maximumRenderWorkers(qMax(1, maximumRenderWorkers)),
+    m_renderWorkerCount(0),
+    m_idleRenderWorkers(),
+    m_rasterCacheSize(rasterCacheSize * 1024),
+    m_rasterCache(m_rasterCacheSize),
+    m_pendingRasters()
 {
 }
 
 PsDocument::~PsDocument()
 {
-    spectre_render_context_free(m_renderContext);
-    m_renderContext = 0;
+    foreach(RenderWorker* renderWorker, m_idleRenderWorkers)
+    {
+        spectre_render_context_free(renderWorker->renderContext);
+        spectre_document_free(renderWorker->document);
+
+        delete renderWorker;
+    }
 
     spectre_document_free(m_document);
     m_document = 0;
@@ -166,7 +241,7 @@ Page* PsDocument::page(int index) const
 
     SpectrePage* page = spectre_document_get_page(m_document, index);
 
-    return page != 0 ? new PsPage(&m_mutex, page, m_renderContext) : 0;
+    return page != 0 ? new PsPage(this, index, page) : 0;
 }
 
 QStringList PsDocument::saveFilter() const
@@ -204,6 +279,13 @@ bool PsDocument::canBePrintedUsingCUPS() const
     return true;
 }
 
+QByteArray PsDocument::renderKey() const
+{
+    return QByteArray("ps") + '\0'
+            + QByteArray::number(m_graphicsAntialiasBits) + '\0'
+            + QByteArray::number(m_textAntialiasBits);
+}
+
 void PsDocument::loadProperties(QStandardItemModel* propertiesModel) const
 {
     Document::loadProperties(propertiesModel);
@@ -227,6 +309,63 @@ void PsDocument::loadProperties(QStandardItemModel* propertiesModel) const
     propertiesModel->appendRow(QList< QStandardItem* >() << new QStandardItem(tr("Language level")) << new QStandardItem(languageLevel));
 }
 
+PsDocument::RenderWorker* PsDocument::acquireRenderWorker() const
+{
+    while(m_idleRenderWorkers.isEmpty() && m_renderWorkerCount >= m_maximumRenderWorkers)
+    {
+        m_condition.wait(&m_mutex);
+    }
+
+    if(!m_idleRenderWorkers.isEmpty())
+    {
+        return m_idleRenderWorkers.takeLast();
+    }
+
+    ++m_renderWorkerCount;
+
+    // each worker owns its own document handle so that Ghostscript instances do not share state
+
+    m_mutex.unlock();
+
+    SpectreDocument* document = spectre_document_new();
+
+    spectre_document_load(document, QFile::encodeName(m_filePath));
+
+    if(spectre_document_status(document) != SPECTRE_STATUS_SUCCESS)
+    {
+        spectre_document_free(document);
+
+        m_mutex.lock();
+
+        --m_renderWorkerCount;
+
+        return 0;
+    }
+
+    SpectreRenderContext* renderContext = spectre_render_context_new();
+
+    spectre_render_context_set_antialias_bits(renderContext, m_graphicsAntialiasBits, m_textAntialiasBits);
+
+    RenderWorker* renderWorker = new RenderWorker;
+
+    renderWorker->document = document;
+    renderWorker->renderContext = renderContext;
+
+    m_mutex.lock();
+
+    return renderWorker;
+}
+
+void PsDocument::releaseRenderWorker(RenderWorker* renderWorker) const
+{
+    if(renderWorker != 0)
+    {
+        m_idleRenderWorkers.append(renderWorker);
+    }
+
+    m_condition.wakeAll();
+}
+
 } // Model
 
 PsSettingsWidget::PsSettingsWidget(QSettings* settings, QWidget* parent) : SettingsWidget(parent),
@@ -249,18 +388,40 @@ PsSettingsWidget::PsSettingsWidget(QSettings* settings, QWidget* parent) : Setti
     m_textAntialisBitsSpinBox->setValue(m_settings->value("textAntialiasBits", 2).toInt());
 
     m_layout->addRow(tr("Text antialias bits:"), m_textAntialisBitsSpinBox);
+
+    // raster cache size
+
+    m_rasterCacheSizeSpinBox = new QSpinBox(this);
+    m_rasterCacheSizeSpinBox->setRange(0, 1024);
+    m_rasterCacheSizeSpinBox->setSuffix(" MB");
+    m_rasterCacheSizeSpinBox->setValue(m_settings->value("rasterCacheSize", 64).toInt());
+
+    m_layout->addRow(tr("Raster cache size:"), m_rasterCacheSizeSpinBox);
+
+    // render workers
+
+    m_renderWorkersSpinBox = new QSpinBox(this);
+    m_renderWorkersSpinBox->setRange(1, 16);
+    m_renderWorkersSpinBox->setToolTip(tr("Parallel rendering requires a thread-safe build of Ghostscript."));
+    m_renderWorkersSpinBox->setValue(m_settings->value("renderWorkers", 1).toInt());
+
+    m_layout->addRow(tr("Render workers:"), m_renderWorkersSpinBox);
 }
 
 void PsSettingsWidget::accept()
 {
     m_settings->setValue("graphicsAntialiasBits", m_graphicsAntialiasBitsSpinBox->value());
     m_settings->setValue("textAntialiasBits", m_textAntialisBitsSpinBox->value());
+    m_settings->setValue("rasterCacheSize", m_rasterCacheSizeSpinBox->value());
+    m_settings->setValue("renderWorkers", m_renderWorkersSpinBox->value());
 }
 
 void PsSettingsWidget::reset()
 {
     m_graphicsAntialiasBitsSpinBox->setValue(4);
     m_textAntialisBitsSpinBox->setValue(2);
+    m_rasterCacheSizeSpinBox->setValue(64);
+    m_renderWorkersSpinBox->setValue(1);
 }
 
 PsPlugin::PsPlugin(QObject* parent) : QObject(parent)
@@ -283,13 +444,11 @@ Model::Document* PsPlugin::loadDocument(const QString& filePath) const
         return 0;
     }
 
-    SpectreRenderContext* renderContext = spectre_render_context_new();
-
-    spectre_render_context_set_antialias_bits(renderContext,
-                                              m_settings->value("graphicsAntialiasBits", 4).toInt(),
-                                              m_settings->value("textAntialiasBits", 2).toInt());
-
-    return new Model::PsDocument(document, renderContext);
+    return new Model::PsDocument(filePath, document,
+                                 m_settings->value("graphicsAntialiasBits", 4).toInt(),
+                                 m_settings->value("textAntialiasBits", 2).toInt(),
+                                 m_settings->value("rasterCacheSize", 64).toInt(),
+                                 m_settings->value("renderWorkers", 1).toInt());
 }
 
 SettingsWidget* PsPlugin::createSettingsWidget(QWidget* parent) const
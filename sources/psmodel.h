@@ -23,8 +23,12 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PSMODEL_H
 #define PSMODEL_H
 
+#include <QCache>
 #include <QCoreApplication>
+#include <QImage>
 #include <QMutex>
+#include <QSet>
+#include <QWaitCondition>
 
 class QFormLayout;
 class QSettings;
@@ -57,11 +61,12 @@ namespace Model
     private:
         Q_DISABLE_COPY(PsPage)
 
-        PsPage(QMutex* mutex, SpectrePage* page, SpectreRenderContext* renderContext);
+        PsPage(const class PsDocument* parent, int index, SpectrePage* page);
 
-        mutable QMutex* m_mutex;
+        const class PsDocument* m_parent;
+
+        int m_index;
         SpectrePage* m_page;
-        SpectreRenderContext* m_renderContext;
 
     };
 
@@ -69,6 +74,7 @@ namespace Model
     {
         Q_DECLARE_TR_FUNCTIONS(Model::PsDocument)
 
+        friend class PsPage;
         friend class qpdfview::PsPlugin;
 
     public:
@@ -85,16 +91,66 @@ namespace Model
 
         bool canBePrintedUsingCUPS() const;
 
+        QByteArray renderKey() const;
+
         void loadProperties(QStandardItemModel* propertiesModel) const;
 
     private:
         Q_DISABLE_COPY(PsDocument)
 
-        PsDocument(SpectreDocument* document, SpectreRenderContext* renderContext);
+        PsDocument(const QString& filePath, SpectreDocument* document, int graphicsAntialiasBits, int textAntialiasBits, int rasterCacheSize, int maximumRenderWorkers);
 
         mutable QMutex m_mutex;
+        mutable QWaitCondition m_condition;
+
+        QString m_filePath;
         SpectreDocument* m_document;
-        SpectreRenderContext* m_renderContext;
+
+        // render workers
+
+        struct RenderWorker
+        {
+            SpectreDocument* document;
+            SpectreRenderContext* renderContext;
+
+        };
+
+        int m_graphicsAntialiasBits;
+        int m_textAntialiasBits;
+
+        int m_maximumRenderWorkers;
+        mutable int m_renderWorkerCount;
+        mutable QList< RenderWorker* > m_idleRenderWorkers;
+
+        RenderWorker* acquireRenderWorker() const;
+        void releaseRenderWorker(RenderWorker* renderWorker) const;
+
+        // rasters
+
+        struct RasterKey
+        {
+            int index;
+            int rotation;
+            int width;
+            int height;
+
+            RasterKey(int index, int rotation, int width, int height) : index(index), rotation(rotation), width(width), height(height) {}
+
+            inline bool operator==(const RasterKey& other) const
+            {
+                return index == other.index
+                    && rotation == other.rotation
+                    && width == other.width
+                    && height == other.height;
+            }
+
+            friend inline uint qHash(const RasterKey& key) { return ((key.index * 31 + key.rotation) * 31 + key.width) * 31 + key.height; }
+
+        };
+
+        int m_rasterCacheSize;
+        mutable QCache< RasterKey, QImage > m_rasterCache;
+        mutable QSet< RasterKey > m_pendingRasters;
 
     };
 }
@@ -119,6 +175,9 @@ private:
     QSpinBox* m_graphicsAntialiasBitsSpinBox;
     QSpinBox* m_textAntialisBitsSpinBox;
 
+    QSpinBox* m_rasterCacheSizeSpinBox;
+    QSpinBox* m_renderWorkersSpinBox;
+
 };
 
 class PsPlugin : public QObject, Plugin
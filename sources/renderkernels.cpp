@@ -0,0 +1,453 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "renderkernels.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+
+#define HAS_RUNTIME_DISPATCH
+
+#include <immintrin.h>
+
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+#endif // __GNUC__ __i386__ __x86_64__
+
+namespace
+{
+
+using namespace qpdfview;
+
+InstructionSet detectInstructionSet()
+{
+#ifdef HAS_RUNTIME_DISPATCH
+
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2"))
+    {
+        return AVX2Instructions;
+    }
+
+    if(__builtin_cpu_supports("sse2"))
+    {
+        return SSE2Instructions;
+    }
+
+#endif // HAS_RUNTIME_DISPATCH
+
+    return ScalarInstructions;
+}
+
+const InstructionSet detectedInstructionSet = detectInstructionSet();
+
+InstructionSet effectiveInstructionSet(InstructionSet instructionSet)
+{
+    return instructionSet < detectedInstructionSet ? instructionSet : detectedInstructionSet;
+}
+
+inline bool hasPaperColor(QRgb paperColor, QRgb pixel)
+{
+    return paperColor == (pixel | 0xff000000u);
+}
+
+int firstNonPaperPixelScalar(QRgb paperColor, const QRgb* line, int begin, int end)
+{
+    for(int x = begin; x < end; ++x)
+    {
+        if(!hasPaperColor(paperColor, line[x]))
+        {
+            return x;
+        }
+    }
+
+    return end;
+}
+
+int lastNonPaperPixelScalar(QRgb paperColor, const QRgb* line, int begin, int end)
+{
+    for(int x = end; x > begin; --x)
+    {
+        if(!hasPaperColor(paperColor, line[x - 1]))
+        {
+            return x - 1;
+        }
+    }
+
+    return begin - 1;
+}
+
+inline QRgb applyFilters(QRgb pixel, int filters)
+{
+    if(filters & GrayscaleFilter)
+    {
+        const int gray = qGray(pixel);
+        const int alpha = qAlpha(pixel);
+
+        pixel = qRgba(gray, gray, gray, alpha);
+    }
+
+    if(filters & InvertFilter)
+    {
+        pixel ^= 0x00ffffffu;
+    }
+
+    return pixel;
+}
+
+void applyFiltersScalar(QRgb* begin, QRgb* end, int filters)
+{
+    for(QRgb* pointer = begin; pointer != end; ++pointer)
+    {
+        *pointer = applyFilters(*pointer, filters);
+    }
+}
+
+#ifdef HAS_RUNTIME_DISPATCH
+
+// the vector loops skip whole blocks of paper and leave the block containing the first other pixel to the scalar loop
+
+TARGET_SSE2 int firstNonPaperPixelSSE2(QRgb paperColor, const QRgb* line, int begin, int end)
+{
+    const __m128i paper = _mm_set1_epi32(static_cast< int >(paperColor));
+    const __m128i alpha = _mm_set1_epi32(static_cast< int >(0xff000000u));
+
+    int x = begin;
+
+    for(; x + 4 <= end; x += 4)
+    {
+        const __m128i pixels = _mm_or_si128(_mm_loadu_si128(reinterpret_cast< const __m128i* >(line + x)), alpha);
+
+        if(_mm_movemask_epi8(_mm_cmpeq_epi32(pixels, paper)) != 0xffff)
+        {
+            break;
+        }
+    }
+
+    return firstNonPaperPixelScalar(paperColor, line, x, end);
+}
+
+TARGET_SSE2 int lastNonPaperPixelSSE2(QRgb paperColor, const QRgb* line, int begin, int end)
+{
+    const __m128i paper = _mm_set1_epi32(static_cast< int >(paperColor));
+    const __m128i alpha = _mm_set1_epi32(static_cast< int >(0xff000000u));
+
+    int x = end;
+
+    for(; x - 4 >= begin; x -= 4)
+    {
+        const __m128i pixels = _mm_or_si128(_mm_loadu_si128(reinterpret_cast< const __m128i* >(line + x - 4)), alpha);
+
+        if(_mm_movemask_epi8(_mm_cmpeq_epi32(pixels, paper)) != 0xffff)
+        {
+            break;
+        }
+    }
+
+    return lastNonPaperPixelScalar(paperColor, line, begin, x);
+}
+
+TARGET_AVX2 int firstNonPaperPixelAVX2(QRgb paperColor, const QRgb* line, int begin, int end)
+{
+    const __m256i paper = _mm256_set1_epi32(static_cast< int >(paperColor));
+    const __m256i alpha = _mm256_set1_epi32(static_cast< int >(0xff000000u));
+
+    int x = begin;
+
+    for(; x + 8 <= end; x += 8)
+    {
+        const __m256i pixels = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast< const __m256i* >(line + x)), alpha);
+
+        if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(pixels, paper)) != -1)
+        {
+            break;
+        }
+    }
+
+    return firstNonPaperPixelScalar(paperColor, line, x, end);
+}
+
+TARGET_AVX2 int lastNonPaperPixelAVX2(QRgb paperColor, const QRgb* line, int begin, int end)
+{
+    const __m256i paper = _mm256_set1_epi32(static_cast< int >(paperColor));
+    const __m256i alpha = _mm256_set1_epi32(static_cast< int >(0xff000000u));
+
+    int x = end;
+
+    for(; x - 8 >= begin; x -= 8)
+    {
+        const __m256i pixels = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast< const __m256i* >(line + x - 8)), alpha);
+
+        if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(pixels, paper)) != -1)
+        {
+            break;
+        }
+    }
+
+    return lastNonPaperPixelScalar(paperColor, line, begin, x);
+}
+
+// same weights as qGray, i.e. (11 * red + 16 * green + 5 * blue) / 32
+
+TARGET_SSE2 void applyFiltersSSE2(QRgb* begin, QRgb* end, int filters)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i alphaMask = _mm_set1_epi32(static_cast< int >(0xff000000u));
+    const __m128i invertMask = _mm_set1_epi32(0x00ffffff);
+
+    QRgb* pointer = begin;
+
+    for(; end - pointer >= 4; pointer += 4)
+    {
+        __m128i* const address = reinterpret_cast< __m128i* >(pointer);
+        __m128i pixels = _mm_loadu_si128(address);
+
+        if(filters & GrayscaleFilter)
+        {
+            const __m128i red = _mm_and_si128(_mm_srli_epi32(pixels, 16), mask);
+            const __m128i green = _mm_and_si128(_mm_srli_epi32(pixels, 8), mask);
+            const __m128i blue = _mm_and_si128(pixels, mask);
+
+            __m128i gray = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(red, 3), _mm_slli_epi32(red, 1)), red);
+            gray = _mm_add_epi32(gray, _mm_slli_epi32(green, 4));
+            gray = _mm_add_epi32(gray, _mm_add_epi32(_mm_slli_epi32(blue, 2), blue));
+            gray = _mm_srli_epi32(gray, 5);
+
+            pixels = _mm_or_si128(_mm_and_si128(pixels, alphaMask), _mm_or_si128(_mm_slli_epi32(gray, 16), _mm_or_si128(_mm_slli_epi32(gray, 8), gray)));
+        }
+
+        if(filters & InvertFilter)
+        {
+            pixels = _mm_xor_si128(pixels, invertMask);
+        }
+
+        _mm_storeu_si128(address, pixels);
+    }
+
+    applyFiltersScalar(pointer, end, filters);
+}
+
+TARGET_AVX2 void applyFiltersAVX2(QRgb* begin, QRgb* end, int filters)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast< int >(0xff000000u));
+    const __m256i invertMask = _mm256_set1_epi32(0x00ffffff);
+
+    QRgb* pointer = begin;
+
+    for(; end - pointer >= 8; pointer += 8)
+    {
+        __m256i* const address = reinterpret_cast< __m256i* >(pointer);
+        __m256i pixels = _mm256_loadu_si256(address);
+
+        if(filters & GrayscaleFilter)
+        {
+            const __m256i red = _mm256_and_si256(_mm256_srli_epi32(pixels, 16), mask);
+            const __m256i green = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), mask);
+            const __m256i blue = _mm256_and_si256(pixels, mask);
+
+            __m256i gray = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(red, 3), _mm256_slli_epi32(red, 1)), red);
+            gray = _mm256_add_epi32(gray, _mm256_slli_epi32(green, 4));
+            gray = _mm256_add_epi32(gray, _mm256_add_epi32(_mm256_slli_epi32(blue, 2), blue));
+            gray = _mm256_srli_epi32(gray, 5);
+
+            pixels = _mm256_or_si256(_mm256_and_si256(pixels, alphaMask), _mm256_or_si256(_mm256_slli_epi32(gray, 16), _mm256_or_si256(_mm256_slli_epi32(gray, 8), gray)));
+        }
+
+        if(filters & InvertFilter)
+        {
+            pixels = _mm256_xor_si256(pixels, invertMask);
+        }
+
+        _mm256_storeu_si256(address, pixels);
+    }
+
+    applyFiltersScalar(pointer, end, filters);
+}
+
+#endif // HAS_RUNTIME_DISPATCH
+
+typedef int (*PaperScan)(QRgb paperColor, const QRgb* line, int begin, int end);
+
+typedef void (*FilterPass)(QRgb* begin, QRgb* end, int filters);
+
+} // anonymous
+
+namespace qpdfview
+{
+
+InstructionSet supportedInstructionSet()
+{
+    return detectedInstructionSet;
+}
+
+const char* instructionSetName(InstructionSet instructionSet)
+{
+    switch(instructionSet)
+    {
+    default:
+    case ScalarInstructions:
+        return "scalar";
+    case SSE2Instructions:
+        return "sse2";
+    case AVX2Instructions:
+        return "avx2";
+    }
+}
+
+QRectF trimMargins(QRgb paperColor, const QImage& image, InstructionSet instructionSet)
+{
+    if(image.isNull())
+    {
+        return QRectF(0.0, 0.0, 1.0, 1.0);
+    }
+
+    if(image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32 && image.format() != QImage::Format_ARGB32_Premultiplied)
+    {
+        return trimMargins(paperColor, image.convertToFormat(QImage::Format_RGB32), instructionSet);
+    }
+
+    PaperScan firstNonPaperPixel = firstNonPaperPixelScalar;
+    PaperScan lastNonPaperPixel = lastNonPaperPixelScalar;
+
+#ifdef HAS_RUNTIME_DISPATCH
+
+    switch(effectiveInstructionSet(instructionSet))
+    {
+    default:
+    case ScalarInstructions:
+        break;
+    case SSE2Instructions:
+        firstNonPaperPixel = firstNonPaperPixelSSE2;
+        lastNonPaperPixel = lastNonPaperPixelSSE2;
+        break;
+    case AVX2Instructions:
+        firstNonPaperPixel = firstNonPaperPixelAVX2;
+        lastNonPaperPixel = lastNonPaperPixelAVX2;
+        break;
+    }
+
+#else
+
+    Q_UNUSED(instructionSet)
+
+#endif // HAS_RUNTIME_DISPATCH
+
+    const int width = image.width();
+    const int height = image.height();
+
+    // find the bounding box of all pixels not having the paper color in a single pass over the scan lines
+
+    int left = width;
+    int right = -1;
+    int top = height;
+    int bottom = -1;
+
+    for(int y = 0; y < height; ++y)
+    {
+        const QRgb* line = reinterpret_cast< const QRgb* >(image.constScanLine(y));
+
+        const int first = firstNonPaperPixel(paperColor, line, 0, width);
+
+        if(first == width)
+        {
+            continue;
+        }
+
+        left = qMin(left, first);
+        right = qMax(right, lastNonPaperPixel(paperColor, line, qMax(first, right + 1), width));
+
+        top = qMin(top, y);
+        bottom = y;
+    }
+
+    left = qMin(left, width / 3);
+    right = qMax(right, 2 * width / 3);
+    top = qMin(top, height / 3);
+    bottom = qMax(bottom, 2 * height / 3);
+
+    left = qMax(left - width / 100, 0);
+    top = qMax(top - height / 100, 0);
+
+    right = qMin(right + width / 100, width);
+    bottom = qMin(bottom + height / 100, height);
+
+    return QRectF(static_cast< qreal >(left) / width,
+                  static_cast< qreal >(top) / height,
+                  static_cast< qreal >(right - left) / width,
+                  static_cast< qreal >(bottom - top) / height);
+}
+
+void applyFilters(QImage& image, int filters, InstructionSet instructionSet)
+{
+    if(image.isNull() || filters == 0)
+    {
+        return;
+    }
+
+    QRgb* const begin = reinterpret_cast< QRgb* >(image.bits());
+    QRgb* const end = reinterpret_cast< QRgb* >(image.bits() + image.byteCount());
+
+    if(image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32)
+    {
+        if(filters & GrayscaleFilter)
+        {
+            applyFiltersScalar(begin, end, GrayscaleFilter);
+        }
+
+        if(filters & InvertFilter)
+        {
+            image.invertPixels();
+        }
+
+        return;
+    }
+
+    FilterPass filterPass = applyFiltersScalar;
+
+#ifdef HAS_RUNTIME_DISPATCH
+
+    switch(effectiveInstructionSet(instructionSet))
+    {
+    default:
+    case ScalarInstructions:
+        break;
+    case SSE2Instructions:
+        filterPass = applyFiltersSSE2;
+        break;
+    case AVX2Instructions:
+        filterPass = applyFiltersAVX2;
+        break;
+    }
+
+#else
+
+    Q_UNUSED(instructionSet)
+
+#endif // HAS_RUNTIME_DISPATCH
+
+    // apply all filters in a single pass over the pixels
+
+    filterPass(begin, end, filters);
+}
+
+} // qpdfview
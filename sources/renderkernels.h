@@ -0,0 +1,56 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef RENDERKERNELS_H
+#define RENDERKERNELS_H
+
+#include <QImage>
+#include <QRectF>
+
+namespace qpdfview
+{
+
+enum InstructionSet
+{
+    ScalarInstructions = 0,
+    SSE2Instructions = 1,
+    AVX2Instructions = 2
+};
+
+// the best instruction set supported by the processor, detected once at runtime
+
+InstructionSet supportedInstructionSet();
+
+const char* instructionSetName(InstructionSet instructionSet);
+
+QRectF trimMargins(QRgb paperColor, const QImage& image, InstructionSet instructionSet = supportedInstructionSet());
+
+enum
+{
+    GrayscaleFilter = 1 << 0,
+    InvertFilter = 1 << 1
+};
+
+void applyFilters(QImage& image, int filters, InstructionSet instructionSet = supportedInstructionSet());
+
+} // qpdfview
+
+#endif // RENDERKERNELS_H
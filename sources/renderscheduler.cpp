@@ -0,0 +1,271 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "renderscheduler.h"
+
+#include <QRectF>
+#include <QThread>
+
+#include "rendertask.h"
+#include "renderstatistics.h"
+
+namespace
+{
+
+const int subordinateBatchSize = 8;
+
+// tiles which were passed over for closer ones for too long are rendered next regardless of their distance
+
+const qint64 visibleDeadline = 500; // ms
+const qint64 prefetchDeadline = 5000; // ms
+
+} // anonymous
+
+namespace qpdfview
+{
+
+class RenderScheduler::Dispatcher : public QRunnable
+{
+public:
+    Dispatcher(RenderScheduler* scheduler) : QRunnable(),
+        m_scheduler(scheduler)
+    {
+    }
+
+    void run()
+    {
+        // the task is only chosen when a worker becomes available so that the order follows the viewport
+
+        if(m_scheduler->m_superior == 0)
+        {
+            const Entry entry = m_scheduler->dequeue();
+
+            if(entry.task != 0)
+            {
+                entry.task->run();
+
+                m_scheduler->finish(entry);
+            }
+
+            return;
+        }
+
+        // a subordinate scheduler works in batches and only while its superior has no visible tiles left
+
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+        for(int count = 0; count < subordinateBatchSize; ++count)
+        {
+            m_scheduler->waitForSuperior();
+
+            const Entry entry = m_scheduler->dequeue();
+
+            if(entry.task == 0)
+            {
+                break;
+            }
+
+            entry.task->run();
+
+            m_scheduler->finish(entry);
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(Dispatcher)
+
+    RenderScheduler* m_scheduler;
+
+};
+
+RenderScheduler::RenderScheduler(QObject* parent) : QObject(parent),
+    m_mutex(),
+    m_center(),
+    m_clock(),
+    m_superior(0),
+    m_visibleCount(0),
+    m_idleCondition(),
+    m_queue(),
+    m_threadPool()
+{
+    m_clock.start();
+}
+
+RenderScheduler::~RenderScheduler()
+{
+    m_threadPool.waitForDone();
+}
+
+void RenderScheduler::enqueue(RenderTask* task, bool prefetch, const QPointF& position)
+{
+    m_mutex.lock();
+    m_queue.append(Entry(task, prefetch, position, m_clock.elapsed() + (prefetch ? prefetchDeadline : visibleDeadline)));
+    const int queueDepth = m_queue.count();
+
+    if(!prefetch)
+    {
+        ++m_visibleCount;
+    }
+
+    m_mutex.unlock();
+
+    if(RenderStatistics::isEnabled())
+    {
+        RenderStatistics::instance()->addQueueDepth(queueDepth);
+    }
+
+    m_threadPool.start(new Dispatcher(this));
+}
+
+bool RenderScheduler::remove(RenderTask* task)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    for(int index = 0; index < m_queue.count(); ++index)
+    {
+        const Entry entry = m_queue.at(index);
+
+        if(entry.task == task)
+        {
+            m_queue.remove(index);
+
+            if(!entry.prefetch && --m_visibleCount == 0)
+            {
+                m_idleCondition.wakeAll();
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void RenderScheduler::setViewport(const QRectF& viewport)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    m_center = viewport.center();
+}
+
+void RenderScheduler::setSuperior(RenderScheduler* superior)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    m_superior = superior;
+}
+
+void RenderScheduler::setMaximumThreadCount(int maximumThreadCount)
+{
+    m_threadPool.setMaxThreadCount(maximumThreadCount);
+}
+
+int RenderScheduler::queueDepth() const
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    return m_queue.count();
+}
+
+void RenderScheduler::waitForSuperior() const
+{
+    QMutexLocker mutexLocker(&m_superior->m_mutex);
+
+    while(m_superior->m_visibleCount > 0)
+    {
+        m_superior->m_idleCondition.wait(&m_superior->m_mutex);
+    }
+}
+
+RenderScheduler::Entry RenderScheduler::dequeue()
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    if(m_queue.isEmpty())
+    {
+        return Entry();
+    }
+
+    // visible tiles always go before prefetched ones, then the earliest missed deadline
+    // and otherwise the tile closest to the viewport center wins
+
+    const qint64 now = m_clock.elapsed();
+
+    int best = 0;
+    qreal bestDistance = (m_queue.at(0).position - m_center).manhattanLength();
+
+    for(int index = 1; index < m_queue.count(); ++index)
+    {
+        const Entry& entry = m_queue.at(index);
+        const Entry& bestEntry = m_queue.at(best);
+        const qreal distance = (entry.position - m_center).manhattanLength();
+
+        if(entry.prefetch != bestEntry.prefetch)
+        {
+            if(!entry.prefetch)
+            {
+                best = index;
+                bestDistance = distance;
+            }
+
+            continue;
+        }
+
+        const bool isOverdue = entry.deadline <= now;
+        const bool bestIsOverdue = bestEntry.deadline <= now;
+
+        if(isOverdue != bestIsOverdue)
+        {
+            if(isOverdue)
+            {
+                best = index;
+                bestDistance = distance;
+            }
+
+            continue;
+        }
+
+        if(isOverdue ? entry.deadline < bestEntry.deadline : distance < bestDistance)
+        {
+            best = index;
+            bestDistance = distance;
+        }
+    }
+
+    const Entry entry = m_queue.at(best);
+
+    m_queue.remove(best);
+
+    return entry;
+}
+
+void RenderScheduler::finish(const Entry& entry)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    if(!entry.prefetch && --m_visibleCount == 0)
+    {
+        m_idleCondition.wakeAll();
+    }
+}
+
+} // qpdfview
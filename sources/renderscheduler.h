@@ -0,0 +1,99 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QPointF>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+class QRectF;
+
+namespace qpdfview
+{
+
+class RenderTask;
+
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RenderScheduler(QObject* parent = 0);
+    ~RenderScheduler();
+
+    void enqueue(RenderTask* task, bool prefetch, const QPointF& position);
+    bool remove(RenderTask* task);
+
+    void setViewport(const QRectF& viewport);
+
+    void setSuperior(RenderScheduler* superior);
+    void setMaximumThreadCount(int maximumThreadCount);
+
+    int queueDepth() const;
+
+private:
+    Q_DISABLE_COPY(RenderScheduler)
+
+    class Dispatcher;
+
+    mutable QMutex m_mutex;
+
+    QPointF m_center;
+    QElapsedTimer m_clock;
+
+    RenderScheduler* m_superior;
+
+    int m_visibleCount;
+    QWaitCondition m_idleCondition;
+
+    void waitForSuperior() const;
+
+    struct Entry
+    {
+        RenderTask* task;
+        bool prefetch;
+        QPointF position;
+        qint64 deadline;
+
+        Entry() : task(0), prefetch(false), position(), deadline(0) {}
+        Entry(RenderTask* task, bool prefetch, const QPointF& position, qint64 deadline) : task(task), prefetch(prefetch), position(position), deadline(deadline) {}
+
+    };
+
+    QVector< Entry > m_queue;
+
+    Entry dequeue();
+    void finish(const Entry& entry);
+
+    QThreadPool m_threadPool;
+
+};
+
+} // qpdfview
+
+#endif // RENDERSCHEDULER_H
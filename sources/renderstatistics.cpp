@@ -0,0 +1,355 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "renderstatistics.h"
+
+#include <cstdlib>
+#include <typeinfo>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QStringList>
+
+#ifdef __GNUG__
+
+#include <cxxabi.h>
+
+#endif // __GNUG__
+
+#include "model.h"
+
+namespace
+{
+
+using namespace qpdfview;
+
+// latencies are counted in buckets of powers of two milliseconds with the last bucket being open
+
+const int latencyBuckets = 14;
+
+int latencyBucket(qint64 latency)
+{
+    int bucket = 0;
+
+    while(bucket < latencyBuckets - 1 && latency >= (Q_INT64_C(1) << bucket))
+    {
+        ++bucket;
+    }
+
+    return bucket;
+}
+
+QString renderParamName(const RenderParam& renderParam)
+{
+    QString name = QString("%1x%2 dpi, %3 degrees")
+            .arg(qRound(renderParam.resolution.devicePixelRatio * renderParam.resolution.resolutionX * renderParam.scaleFactor))
+            .arg(qRound(renderParam.resolution.devicePixelRatio * renderParam.resolution.resolutionY * renderParam.scaleFactor))
+            .arg(90 * static_cast< int >(renderParam.rotation));
+
+    if(renderParam.invertColors)
+    {
+        name += QLatin1String(", inverted");
+    }
+
+    if(renderParam.convertToGrayscale)
+    {
+        name += QLatin1String(", grayscale");
+    }
+
+    return name;
+}
+
+QByteArray jsonString(const QString& string)
+{
+    QByteArray json = string.toUtf8();
+
+    json.replace('\\', "\\\\");
+    json.replace('"', "\\\"");
+
+    return '"' + json + '"';
+}
+
+} // anonymous
+
+namespace qpdfview
+{
+
+RenderStatistics* RenderStatistics::s_instance = 0;
+QAtomicInt RenderStatistics::s_enabled;
+
+RenderStatistics* RenderStatistics::instance()
+{
+    if(s_instance == 0)
+    {
+        s_instance = new RenderStatistics;
+    }
+
+    return s_instance;
+}
+
+bool RenderStatistics::isEnabled()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+
+    return s_enabled.load() != 0;
+
+#else
+
+    return !s_enabled.testAndSetRelaxed(0, 0);
+
+#endif // QT_VERSION
+}
+
+void RenderStatistics::setEnabled(bool enabled)
+{
+    // render tasks only report once enabled, so the instance is created here on the main thread
+
+    instance();
+
+    s_enabled.fetchAndStoreRelease(enabled ? 1 : 0);
+}
+
+void RenderStatistics::addRender(const Model::Page* page, const RenderParam& renderParam, qint64 latency, bool preview)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    Counters& backend = m_backends[backendName(page)];
+    Counters& param = m_renderParams[renderParamName(renderParam)];
+
+    if(preview)
+    {
+        ++backend.previews;
+        ++param.previews;
+    }
+    else
+    {
+        ++backend.renders;
+        ++param.renders;
+
+        backend.addLatency(latency);
+        param.addLatency(latency);
+    }
+}
+
+void RenderStatistics::addDiskCacheHit(const Model::Page* page, const RenderParam& renderParam)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    ++m_backends[backendName(page)].diskCacheHits;
+    ++m_renderParams[renderParamName(renderParam)].diskCacheHits;
+}
+
+void RenderStatistics::addCancellation(const Model::Page* page, const RenderParam& renderParam)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    ++m_backends[backendName(page)].cancellations;
+    ++m_renderParams[renderParamName(renderParam)].cancellations;
+}
+
+void RenderStatistics::addCacheLookup(bool thumbnail, bool hit)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    CacheLookups& lookups = thumbnail ? m_thumbnailLookups : m_tileLookups;
+
+    if(hit)
+    {
+        ++lookups.hits;
+    }
+    else
+    {
+        ++lookups.misses;
+    }
+}
+
+void RenderStatistics::addQueueDepth(int queueDepth)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    m_maximumQueueDepth = qMax(m_maximumQueueDepth, queueDepth);
+}
+
+QString RenderStatistics::summary() const
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    QStringList lines;
+
+    const qint64 tileLookups = m_tileLookups.hits + m_tileLookups.misses;
+    const qint64 thumbnailLookups = m_thumbnailLookups.hits + m_thumbnailLookups.misses;
+
+    lines.append(QCoreApplication::translate("qpdfview::RenderStatistics", "Tile cache: %1% hits of %2 lookups")
+                 .arg(tileLookups > 0 ? 100 * m_tileLookups.hits / tileLookups : 0).arg(tileLookups));
+    lines.append(QCoreApplication::translate("qpdfview::RenderStatistics", "Thumbnail cache: %1% hits of %2 lookups")
+                 .arg(thumbnailLookups > 0 ? 100 * m_thumbnailLookups.hits / thumbnailLookups : 0).arg(thumbnailLookups));
+
+    for(QMap< QString, Counters >::const_iterator backend = m_backends.constBegin(); backend != m_backends.constEnd(); ++backend)
+    {
+        lines.append(QCoreApplication::translate("qpdfview::RenderStatistics", "%1: %2 renders, %3 ms average, %4 ms maximum, %5 previews, %6 from disk, %7 canceled")
+                     .arg(backend.key())
+                     .arg(backend->renders)
+                     .arg(backend->renders > 0 ? backend->totalLatency / backend->renders : 0)
+                     .arg(backend->maximumLatency)
+                     .arg(backend->previews)
+                     .arg(backend->diskCacheHits)
+                     .arg(backend->cancellations));
+    }
+
+    lines.append(QCoreApplication::translate("qpdfview::RenderStatistics", "Maximum queue depth: %1").arg(m_maximumQueueDepth));
+
+    return lines.join(QLatin1String("\n"));
+}
+
+QByteArray RenderStatistics::toJson() const
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    QByteArray json;
+
+    json += "{\n  \"cache\": {\n";
+    json += "    \"tiles\": { \"hits\": " + QByteArray::number(m_tileLookups.hits) + ", \"misses\": " + QByteArray::number(m_tileLookups.misses) + " },\n";
+    json += "    \"thumbnails\": { \"hits\": " + QByteArray::number(m_thumbnailLookups.hits) + ", \"misses\": " + QByteArray::number(m_thumbnailLookups.misses) + " }\n";
+    json += "  },\n";
+
+    json += "  \"maximumQueueDepth\": " + QByteArray::number(m_maximumQueueDepth) + ",\n";
+
+    json += "  \"backends\": ";
+    writeCounters(json, m_backends);
+    json += ",\n";
+
+    json += "  \"renderParams\": ";
+    writeCounters(json, m_renderParams);
+    json += "\n}\n";
+
+    return json;
+}
+
+bool RenderStatistics::save(const QString& filePath) const
+{
+    QFile file(filePath);
+
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    return file.write(toJson()) != -1;
+}
+
+RenderStatistics::RenderStatistics() :
+    m_mutex(),
+    m_backends(),
+    m_renderParams(),
+    m_backendNames(),
+    m_tileLookups(),
+    m_thumbnailLookups(),
+    m_maximumQueueDepth(0)
+{
+}
+
+RenderStatistics::Counters::Counters() :
+    renders(0),
+    previews(0),
+    diskCacheHits(0),
+    cancellations(0),
+    totalLatency(0),
+    maximumLatency(0),
+    latencyHistogram(latencyBuckets, 0)
+{
+}
+
+void RenderStatistics::Counters::addLatency(qint64 latency)
+{
+    totalLatency += latency;
+    maximumLatency = qMax(maximumLatency, latency);
+
+    ++latencyHistogram[latencyBucket(latency)];
+}
+
+QString RenderStatistics::backendName(const Model::Page* page)
+{
+    // the backend is identified by the dynamic type of its pages, e.g. "PdfPage" or "DjVuPage"
+
+    const char* typeName = typeid(*page).name();
+
+    QHash< const char*, QString >::const_iterator name = m_backendNames.constFind(typeName);
+
+    if(name != m_backendNames.constEnd())
+    {
+        return *name;
+    }
+
+    QString backendName = QString::fromLatin1(typeName);
+
+#ifdef __GNUG__
+
+    int status = 0;
+    char* demangledName = abi::__cxa_demangle(typeName, 0, 0, &status);
+
+    if(status == 0 && demangledName != 0)
+    {
+        backendName = QString::fromLatin1(demangledName).section(QLatin1String("::"), -1);
+    }
+
+    std::free(demangledName);
+
+#endif // __GNUG__
+
+    m_backendNames.insert(typeName, backendName);
+
+    return backendName;
+}
+
+void RenderStatistics::writeCounters(QByteArray& json, const QMap< QString, Counters >& counters)
+{
+    json += "{";
+
+    for(QMap< QString, Counters >::const_iterator counter = counters.constBegin(); counter != counters.constEnd(); ++counter)
+    {
+        json += counter == counters.constBegin() ? "\n" : ",\n";
+
+        json += "    " + jsonString(counter.key()) + ": {\n";
+        json += "      \"renders\": " + QByteArray::number(counter->renders) + ",\n";
+        json += "      \"previews\": " + QByteArray::number(counter->previews) + ",\n";
+        json += "      \"diskCacheHits\": " + QByteArray::number(counter->diskCacheHits) + ",\n";
+        json += "      \"cancellations\": " + QByteArray::number(counter->cancellations) + ",\n";
+        json += "      \"averageLatency\": " + QByteArray::number(counter->renders > 0 ? counter->totalLatency / counter->renders : 0) + ",\n";
+        json += "      \"maximumLatency\": " + QByteArray::number(counter->maximumLatency) + ",\n";
+        json += "      \"latencyHistogram\": {";
+
+        for(int bucket = 0; bucket < latencyBuckets; ++bucket)
+        {
+            const QByteArray label = bucket < latencyBuckets - 1
+                    ? "<" + QByteArray::number(Q_INT64_C(1) << bucket) + "ms"
+                    : ">=" + QByteArray::number(Q_INT64_C(1) << (bucket - 1)) + "ms";
+
+            json += (bucket == 0 ? " \"" : ", \"") + label + "\": " + QByteArray::number(counter->latencyHistogram.at(bucket));
+        }
+
+        json += " }\n    }";
+    }
+
+    json += counters.isEmpty() ? "}" : "\n  }";
+}
+
+} // qpdfview
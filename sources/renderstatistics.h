@@ -0,0 +1,120 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef RENDERSTATISTICS_H
+#define RENDERSTATISTICS_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "global.h"
+
+namespace qpdfview
+{
+
+namespace Model
+{
+class Page;
+}
+
+class RenderStatistics
+{
+public:
+    static RenderStatistics* instance();
+
+    // nothing is collected until enabled so that rendering does not pay for the statistics otherwise
+
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+    void addRender(const Model::Page* page, const RenderParam& renderParam, qint64 latency, bool preview);
+    void addDiskCacheHit(const Model::Page* page, const RenderParam& renderParam);
+    void addCancellation(const Model::Page* page, const RenderParam& renderParam);
+
+    void addCacheLookup(bool thumbnail, bool hit);
+    void addQueueDepth(int queueDepth);
+
+    QString summary() const;
+
+    QByteArray toJson() const;
+    bool save(const QString& filePath) const;
+
+private:
+    Q_DISABLE_COPY(RenderStatistics)
+
+    static RenderStatistics* s_instance;
+    static QAtomicInt s_enabled;
+
+    RenderStatistics();
+
+    mutable QMutex m_mutex;
+
+    struct Counters
+    {
+        qint64 renders;
+        qint64 previews;
+        qint64 diskCacheHits;
+        qint64 cancellations;
+
+        qint64 totalLatency;
+        qint64 maximumLatency;
+
+        QVector< qint64 > latencyHistogram;
+
+        Counters();
+
+        void addLatency(qint64 latency);
+
+    };
+
+    QMap< QString, Counters > m_backends;
+    QMap< QString, Counters > m_renderParams;
+
+    QHash< const char*, QString > m_backendNames;
+
+    QString backendName(const Model::Page* page);
+
+    struct CacheLookups
+    {
+        qint64 hits;
+        qint64 misses;
+
+        CacheLookups() : hits(0), misses(0) {}
+
+    };
+
+    CacheLookups m_tileLookups;
+    CacheLookups m_thumbnailLookups;
+
+    int m_maximumQueueDepth;
+
+    static void writeCounters(QByteArray& json, const QMap< QString, Counters >& counters);
+
+};
+
+} // qpdfview
+
+#endif // RENDERSTATISTICS_H
@@ -22,9 +22,16 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include "rendertask.h"
 
 #include <qmath.h>
+#include <QDataStream>
+#include <QElapsedTimer>
 #include <QThreadPool>
+#include <QTransform>
 
 #include "model.h"
+#include "renderkernels.h"
+#include "renderscheduler.h"
+#include "diskcache.h"
+#include "renderstatistics.h"
 
 namespace
 {
@@ -94,6 +101,33 @@ int loadWasCanceled(const QAtomicInt& wasCanceled)
 #endif // QT_VERSION
 }
 
+QByteArray diskCacheKey(const QByteArray& prefix, const RenderParam& renderParam,
+                        const QRect& rect, bool useThumbnail, bool trimMargins, const QColor& paperColor)
+{
+    if(prefix.isEmpty())
+    {
+        return QByteArray();
+    }
+
+    QByteArray key;
+
+    QDataStream(&key, QIODevice::WriteOnly)
+            << prefix
+            << renderParam.resolution.resolutionX
+            << renderParam.resolution.resolutionY
+            << renderParam.resolution.devicePixelRatio
+            << renderParam.scaleFactor
+            << static_cast< int >(renderParam.rotation)
+            << renderParam.invertColors
+            << renderParam.convertToGrayscale
+            << rect
+            << useThumbnail
+            << trimMargins
+            << paperColor.rgb();
+
+    return key;
+}
+
 qreal scaledResolutionX(const RenderParam& renderParam)
 {
     return renderParam.resolution.devicePixelRatio *
@@ -106,110 +140,61 @@ qreal scaledResolutionY(const RenderParam& renderParam)
             renderParam.resolution.resolutionY * renderParam.scaleFactor;
 }
 
-bool columnHasPaperColor(int x, QRgb paperColor, const QImage& image)
+int renderFilters(const RenderParam& renderParam)
 {
-    const int height = image.height();
+    int filters = 0;
 
-    for(int y = 0; y < height; ++y)
+    if(renderParam.convertToGrayscale)
     {
-        if(paperColor != (image.pixel(x, y) | 0xff000000u))
-        {
-            return false;
-        }
+        filters |= GrayscaleFilter;
     }
 
-    return true;
-}
-
-bool rowHasPaperColor(int y, QRgb paperColor, const QImage& image)
-{
-    const int width = image.width();
-
-    for(int x = 0; x < width; ++x)
+    if(renderParam.invertColors)
     {
-        if(paperColor != (image.pixel(x, y) | 0xff000000u))
-        {
-            return false;
-        }
+        filters |= InvertFilter;
     }
 
-    return true;
+    return filters;
 }
 
-QRectF trimMargins(QRgb paperColor, const QImage& image)
-{
-    if(image.isNull())
-    {
-        return QRectF(0.0, 0.0, 1.0, 1.0);
-    }
+// a preview is rendered at a quarter of the resolution at most and limited in area
+// so that it can be painted within a frame while the full-quality tile is rendered
 
-    const int width = image.width();
-    const int height = image.height();
+const qreal maximumPreviewFactor = 0.25;
+const qreal maximumPreviewArea = 256.0 * 256.0;
 
-    int left;
-    for(left = 0; left < width; ++left)
-    {
-        if(!columnHasPaperColor(left, paperColor, image))
-        {
-            break;
-        }
-    }
-    left = qMin(left, width / 3);
+qreal previewFactor(const QRect& rect)
+{
+    const qreal area = qreal(rect.width()) * qreal(rect.height());
 
-    int right;
-    for(right = width - 1; right >= left; --right)
+    if(area <= 0.0)
     {
-        if(!columnHasPaperColor(right, paperColor, image))
-        {
-            break;
-        }
+        return 1.0;
     }
-    right = qMax(right, 2 * width / 3);
 
-    int top;
-    for(top = 0; top < height; ++top)
+    return qMin(maximumPreviewFactor, qSqrt(maximumPreviewArea / area));
+}
+
+QImage fitThumbnail(QImage thumbnail, Rotation rotation, const QSize& size)
+{
+    if(thumbnail.isNull())
     {
-        if(!rowHasPaperColor(top, paperColor, image))
-        {
-            break;
-        }
+        return QImage();
     }
-    top = qMin(top, height / 3);
 
-    int bottom;
-    for(bottom = height - 1; bottom >= top; --bottom)
+    if(rotation != RotateBy0)
     {
-        if(!rowHasPaperColor(bottom, paperColor, image))
-        {
-            break;
-        }
+        thumbnail = thumbnail.transformed(QTransform().rotate(90.0 * rotation));
     }
-    bottom = qMax(bottom, 2 * height / 3);
-
-    left = qMax(left - width / 100, 0);
-    top = qMax(top - height / 100, 0);
-
-    right = qMin(right + width / 100, width);
-    bottom = qMin(bottom + height / 100, height);
 
-    return QRectF(static_cast< qreal >(left) / width,
-                  static_cast< qreal >(top) / height,
-                  static_cast< qreal >(right - left) / width,
-                  static_cast< qreal >(bottom - top) / height);
-}
-
-void convertToGrayscale(QImage& image)
-{
-    QRgb* const begin = reinterpret_cast< QRgb* >(image.bits());
-    QRgb* const end = reinterpret_cast< QRgb* >(image.bits() + image.byteCount());
+    // thumbnails much smaller than requested would only be a blurry substitute for rendering
 
-    for(QRgb* pointer = begin; pointer != end; ++pointer)
+    if(2 * thumbnail.width() < size.width() && 2 * thumbnail.height() < size.height())
     {
-        const int gray = qGray(*pointer);
-        const int alpha = qAlpha(*pointer);
-
-        *pointer = qRgba(gray, gray, gray, alpha);
+        return QImage();
     }
+
+    return thumbnail.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation).convertToFormat(QImage::Format_RGB32);
 }
 
 } // anonymous
@@ -224,8 +209,12 @@ RenderTask::RenderTask(Model::Page* page, QObject* parent) : QObject(parent), QR
     m_renderParam(),
     m_rect(),
     m_prefetch(false),
+    m_renderPreview(false),
+    m_useThumbnail(false),
     m_trimMargins(false),
-    m_paperColor()
+    m_paperColor(),
+    m_diskCacheKey(),
+    m_scheduler(0)
 {
     setAutoDelete(false);
 }
@@ -264,41 +253,108 @@ bool RenderTask::wasCanceledForcibly() const
 
 void RenderTask::run()
 {
-#define CANCELLATION_POINT if(testCancellation(m_wasCanceled, m_prefetch)) { finish(); return; }
+#define CANCELLATION_POINT if(testCancellation(m_wasCanceled, m_prefetch)) { if(RenderStatistics::isEnabled()) { RenderStatistics::instance()->addCancellation(m_page, m_renderParam); } finish(); return; }
 
     CANCELLATION_POINT
 
     QImage image;
     QRectF cropRect;
 
-    image = m_page->render(scaledResolutionX(m_renderParam), scaledResolutionY(m_renderParam),
-                           m_renderParam.rotation, m_rect);
+    const QByteArray key = diskCacheKey(m_diskCacheKey, m_renderParam, m_rect, m_useThumbnail, m_trimMargins, m_paperColor);
 
-#if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
+    const bool loadedFromDiskCache = !key.isEmpty() && DiskCache::instance()->load(key, image, cropRect);
 
-    image.setDevicePixelRatio(m_renderParam.resolution.devicePixelRatio);
+    if(loadedFromDiskCache && RenderStatistics::isEnabled())
+    {
+        RenderStatistics::instance()->addDiskCacheHit(m_page, m_renderParam);
+    }
 
-#endif // QT_VERSION
+    QElapsedTimer renderTimer;
 
-    if(m_trimMargins)
+    if(!loadedFromDiskCache && m_renderPreview)
     {
-        CANCELLATION_POINT
+        const qreal factor = previewFactor(m_rect);
+
+        if(factor < 1.0)
+        {
+            const QRect previewRect = QRectF(factor * m_rect.left(), factor * m_rect.top(),
+                                             factor * m_rect.width(), factor * m_rect.height()).toAlignedRect();
+
+            renderTimer.start();
 
-        cropRect = trimMargins(m_paperColor.rgb(), image);
+            QImage previewImage = m_page->render(factor * scaledResolutionX(m_renderParam), factor * scaledResolutionY(m_renderParam),
+                                                 m_renderParam.rotation, previewRect);
+
+            if(RenderStatistics::isEnabled())
+            {
+                RenderStatistics::instance()->addRender(m_page, m_renderParam, renderTimer.elapsed(), true);
+            }
+
+            CANCELLATION_POINT
+
+            const int filters = renderFilters(m_renderParam);
+
+            if(filters != 0 && !previewImage.isNull())
+            {
+                applyFilters(previewImage, filters);
+            }
+
+            CANCELLATION_POINT
+
+            emit previewReady(m_renderParam,
+                              m_rect,
+                              previewImage);
+        }
     }
 
-    if(m_renderParam.convertToGrayscale)
+    if(!loadedFromDiskCache && m_useThumbnail)
     {
+        image = fitThumbnail(m_page->thumbnail(), m_renderParam.rotation, m_rect.size());
+
         CANCELLATION_POINT
+    }
+
+    if(!loadedFromDiskCache && image.isNull())
+    {
+        renderTimer.start();
+
+        image = m_page->render(scaledResolutionX(m_renderParam), scaledResolutionY(m_renderParam),
+                               m_renderParam.rotation, m_rect);
 
-        convertToGrayscale(image);
+        if(RenderStatistics::isEnabled())
+        {
+            RenderStatistics::instance()->addRender(m_page, m_renderParam, renderTimer.elapsed(), false);
+        }
     }
 
-    if(m_renderParam.invertColors)
+#if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
+
+    image.setDevicePixelRatio(m_renderParam.resolution.devicePixelRatio);
+
+#endif // QT_VERSION
+
+    if(!loadedFromDiskCache)
     {
-        CANCELLATION_POINT
+        if(m_trimMargins)
+        {
+            CANCELLATION_POINT
+
+            cropRect = trimMargins(m_paperColor.rgb(), image);
+        }
 
-        image.invertPixels();
+        const int filters = renderFilters(m_renderParam);
+
+        if(filters != 0)
+        {
+            CANCELLATION_POINT
+
+            applyFilters(image, filters);
+        }
+
+        if(!key.isEmpty())
+        {
+            DiskCache::instance()->store(key, image, cropRect);
+        }
     }
 
     CANCELLATION_POINT
@@ -312,30 +368,64 @@ void RenderTask::run()
 #undef CANCELLATION_POINT
 }
 
-void RenderTask::start(const RenderParam& renderParam,
-                       const QRect& rect, bool prefetch,
-                       bool trimMargins, const QColor& paperColor)
+void RenderTask::prepare(const RenderParam& renderParam,
+                         const QRect& rect, bool prefetch, bool renderPreview, bool useThumbnail,
+                         bool trimMargins, const QColor& paperColor,
+                         const QByteArray& diskCacheKey)
 {
     m_renderParam = renderParam;
 
     m_rect = rect;
     m_prefetch = prefetch;
+    m_renderPreview = renderPreview && !prefetch;
+    m_useThumbnail = useThumbnail;
 
     m_trimMargins = trimMargins;
     m_paperColor = paperColor;
 
+    m_diskCacheKey = diskCacheKey;
+
     m_mutex.lock();
     m_isRunning = true;
     m_mutex.unlock();
 
     resetCancellation(m_wasCanceled);
+}
 
-    QThreadPool::globalInstance()->start(this, prefetch ? 0 : 1);
+void RenderTask::start(const RenderParam& renderParam,
+                       const QRect& rect, bool prefetch, bool renderPreview, bool useThumbnail,
+                       bool trimMargins, const QColor& paperColor,
+                       const QByteArray& diskCacheKey,
+                       RenderScheduler* scheduler, const QPointF& position)
+{
+    prepare(renderParam, rect, prefetch, renderPreview, useThumbnail, trimMargins, paperColor, diskCacheKey);
+
+    m_scheduler = scheduler;
+
+    if(scheduler != 0)
+    {
+        scheduler->enqueue(this, prefetch, position);
+    }
+    else
+    {
+        QThreadPool::globalInstance()->start(this, prefetch ? 0 : 1);
+    }
 }
 
 void RenderTask::cancel(bool force)
 {
     setCancellation(m_wasCanceled, force);
+
+    // a task still queued is taken out so that waiting for it does not depend on the tasks of a superior scheduler
+
+    if(force && m_scheduler != 0 && m_scheduler->remove(this))
+    {
+        m_mutex.lock();
+        m_isRunning = false;
+        m_mutex.unlock();
+
+        m_waitCondition.wakeAll();
+    }
 }
 
 void RenderTask::finish()
@@ -38,6 +38,8 @@ namespace Model
 class Page;
 }
 
+class RenderScheduler;
+
 class RenderTask : public QObject, QRunnable
 {
     Q_OBJECT
@@ -55,6 +57,13 @@ public:
 
     void run();
 
+    // prepares the task so that it can be run on the calling thread instead of being started
+
+    void prepare(const RenderParam& renderParam,
+                 const QRect& rect, bool prefetch, bool renderPreview, bool useThumbnail,
+                 bool trimMargins, const QColor& paperColor,
+                 const QByteArray& diskCacheKey = QByteArray());
+
 signals:
     void finished();
 
@@ -62,10 +71,16 @@ signals:
                     const QRect& rect, bool prefetch,
                     QImage image, QRectF cropRect);
 
+    void previewReady(const RenderParam& renderParam,
+                      const QRect& rect,
+                      QImage image);
+
 public slots:
     void start(const RenderParam& renderParam,
-               const QRect& rect, bool prefetch,
-               bool trimMargins, const QColor& paperColor);
+               const QRect& rect, bool prefetch, bool renderPreview, bool useThumbnail,
+               bool trimMargins, const QColor& paperColor,
+               const QByteArray& diskCacheKey = QByteArray(),
+               RenderScheduler* scheduler = 0, const QPointF& position = QPointF());
 
     void cancel(bool force = false);
 
@@ -87,10 +102,16 @@ private:
 
     QRect m_rect;
     bool m_prefetch;
+    bool m_renderPreview;
+    bool m_useThumbnail;
 
     bool m_trimMargins;
     QColor m_paperColor;
 
+    QByteArray m_diskCacheKey;
+
+    RenderScheduler* m_scheduler;
+
 };
 
 } // qpdfview
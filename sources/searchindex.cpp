@@ -0,0 +1,327 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "searchindex.h"
+
+#include <QDataStream>
+#include <QSet>
+#include <QStringList>
+
+#include "model.h"
+
+namespace
+{
+
+enum
+{
+    NotCanceled = 0,
+    Canceled = 1
+};
+
+void setCancellation(QAtomicInt& wasCanceled)
+{
+#if QT_VERSION > QT_VERSION_CHECK(5,0,0)
+
+    wasCanceled.storeRelease(Canceled);
+
+#else
+
+    wasCanceled.fetchAndStoreRelease(Canceled);
+
+#endif // QT_VERSION
+}
+
+void resetCancellation(QAtomicInt& wasCanceled)
+{
+#if QT_VERSION > QT_VERSION_CHECK(5,0,0)
+
+    wasCanceled.storeRelease(NotCanceled);
+
+#else
+
+    wasCanceled.fetchAndStoreRelease(NotCanceled);
+
+#endif // QT_VERSION
+}
+
+bool testCancellation(QAtomicInt& wasCanceled)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+
+    return wasCanceled.load() != NotCanceled;
+
+#else
+
+    return !wasCanceled.testAndSetRelaxed(NotCanceled, NotCanceled);
+
+#endif // QT_VERSION
+}
+
+void releaseReady(QAtomicInt& isReady, bool value)
+{
+#if QT_VERSION > QT_VERSION_CHECK(5,0,0)
+
+    isReady.storeRelease(value ? 1 : 0);
+
+#else
+
+    isReady.fetchAndStoreRelease(value ? 1 : 0);
+
+#endif // QT_VERSION
+}
+
+bool acquireReady(QAtomicInt& isReady)
+{
+#if QT_VERSION > QT_VERSION_CHECK(5,0,0)
+
+    return isReady.loadAcquire() != 0;
+
+#else
+
+    return isReady.fetchAndAddAcquire(0) != 0;
+
+#endif // QT_VERSION
+}
+
+const quint32 magic = 0x71707369;
+const quint32 version = 1;
+
+QStringList extractWords(const QString& text)
+{
+    const QString normalizedText = text.normalized(QString::NormalizationForm_KC).toCaseFolded();
+
+    QStringList words;
+    QString word;
+
+    for(int index = 0; index < normalizedText.length(); ++index)
+    {
+        const QChar character = normalizedText.at(index);
+
+        if(character.isLetterOrNumber() || character.isMark())
+        {
+            word.append(character);
+        }
+        else if(!word.isEmpty())
+        {
+            words.append(word);
+            word.clear();
+        }
+    }
+
+    if(!word.isEmpty())
+    {
+        words.append(word);
+    }
+
+    return words;
+}
+
+} // anonymous
+
+namespace qpdfview
+{
+
+SearchIndex::SearchIndex(QObject* parent) : QThread(parent),
+    m_wasCanceled(NotCanceled),
+    m_isReady(0),
+    m_pages(),
+    m_numberOfPages(0),
+    m_words()
+{
+}
+
+bool SearchIndex::isReady() const
+{
+    return acquireReady(m_isReady);
+}
+
+QVector< bool > SearchIndex::candidatePages(const QString& text) const
+{
+    if(!isReady())
+    {
+        return QVector< bool >();
+    }
+
+    const QStringList words = extractWords(text);
+
+    if(words.isEmpty())
+    {
+        return QVector< bool >();
+    }
+
+    QVector< bool > candidates(m_numberOfPages, true);
+
+    foreach(const QString& word, words)
+    {
+        QVector< bool > matches(m_numberOfPages, false);
+
+        // the search text need not start or end at word boundaries, hence the substring match
+
+        for(QHash< QString, QVector< int > >::const_iterator iterator = m_words.constBegin(); iterator != m_words.constEnd(); ++iterator)
+        {
+            if(iterator.key().contains(word))
+            {
+                foreach(int index, iterator.value())
+                {
+                    matches[index] = true;
+                }
+            }
+        }
+
+        for(int index = 0; index < m_numberOfPages; ++index)
+        {
+            candidates[index] = candidates.at(index) && matches.at(index);
+        }
+    }
+
+    return candidates;
+}
+
+QByteArray SearchIndex::save() const
+{
+    if(!isReady())
+    {
+        return QByteArray();
+    }
+
+    QByteArray data;
+
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    stream << magic << version << static_cast< qint32 >(m_numberOfPages) << m_words;
+
+    return qCompress(data, 1);
+}
+
+bool SearchIndex::restore(const QByteArray& data, int numberOfPages)
+{
+    clear();
+
+    if(data.isEmpty())
+    {
+        return false;
+    }
+
+    const QByteArray uncompressedData = qUncompress(data);
+
+    QDataStream stream(uncompressedData);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 dataMagic = 0;
+    quint32 dataVersion = 0;
+    qint32 dataNumberOfPages = 0;
+    QHash< QString, QVector< int > > words;
+
+    stream >> dataMagic >> dataVersion >> dataNumberOfPages >> words;
+
+    if(stream.status() != QDataStream::Ok || dataMagic != magic || dataVersion != version || dataNumberOfPages != numberOfPages)
+    {
+        return false;
+    }
+
+    for(QHash< QString, QVector< int > >::const_iterator iterator = words.constBegin(); iterator != words.constEnd(); ++iterator)
+    {
+        foreach(int index, iterator.value())
+        {
+            if(index < 0 || index >= numberOfPages)
+            {
+                return false;
+            }
+        }
+    }
+
+    m_numberOfPages = numberOfPages;
+    m_words = words;
+
+    releaseReady(m_isReady, true);
+
+    return true;
+}
+
+void SearchIndex::run()
+{
+    QHash< QString, QVector< int > > words;
+    bool hasText = false;
+
+    for(int index = 0; index < m_pages.count(); ++index)
+    {
+        if(testCancellation(m_wasCanceled))
+        {
+            return;
+        }
+
+        const Model::Page* page = m_pages.at(index);
+
+        const QStringList pageWords = extractWords(page->text(QRectF(QPointF(), page->size())));
+
+        foreach(const QString& word, pageWords.toSet())
+        {
+            words[word].append(index);
+        }
+
+        hasText = hasText || !pageWords.isEmpty();
+    }
+
+    // a document without any extractable text does not allow to exclude pages
+
+    if(!hasText)
+    {
+        return;
+    }
+
+    m_numberOfPages = m_pages.count();
+    m_words = words;
+
+    releaseReady(m_isReady, true);
+}
+
+void SearchIndex::start(const QVector< Model::Page* >& pages)
+{
+    clear();
+
+    m_pages = pages;
+
+    resetCancellation(m_wasCanceled);
+
+    QThread::start(QThread::LowestPriority);
+}
+
+void SearchIndex::cancel()
+{
+    setCancellation(m_wasCanceled);
+}
+
+void SearchIndex::clear()
+{
+    cancel();
+    wait();
+
+    releaseReady(m_isReady, false);
+
+    m_pages.clear();
+
+    m_numberOfPages = 0;
+    m_words.clear();
+}
+
+} // qpdfview
@@ -0,0 +1,75 @@
+/*
+
+Copyright 2014 Adam Reichold
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QHash>
+#include <QThread>
+#include <QVector>
+
+namespace qpdfview
+{
+
+namespace Model
+{
+class Page;
+}
+
+class SearchIndex : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit SearchIndex(QObject* parent = 0);
+
+    bool isReady() const;
+
+    QVector< bool > candidatePages(const QString& text) const;
+
+    QByteArray save() const;
+    bool restore(const QByteArray& data, int numberOfPages);
+
+    void run();
+
+public slots:
+    void start(const QVector< Model::Page* >& pages);
+
+    void cancel();
+    void clear();
+
+private:
+    Q_DISABLE_COPY(SearchIndex)
+
+    QAtomicInt m_wasCanceled;
+    mutable QAtomicInt m_isReady;
+
+    QVector< Model::Page* > m_pages;
+
+    int m_numberOfPages;
+    QHash< QString, QVector< int > > m_words;
+
+};
+
+} // qpdfview
+
+#endif // SEARCHINDEX_H
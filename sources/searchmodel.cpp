@@ -215,6 +215,28 @@ bool SearchModel::hasResultsOnPage(DocumentView* view, int page) const
     return results != 0 && qBinaryFind(results->begin(), results->end(), page) != results->end();
 }
 
+QVector< int > SearchModel::pagesWithResults(DocumentView* view) const
+{
+    QVector< int > pages;
+
+    const Results* results = m_results.value(view, 0);
+
+    if(results == 0)
+    {
+        return pages;
+    }
+
+    foreach(const Result& result, *results)
+    {
+        if(pages.isEmpty() || pages.last() != result.first)
+        {
+            pages.append(result.first);
+        }
+    }
+
+    return pages;
+}
+
 int SearchModel::numberOfResultsOnPage(DocumentView* view, int page) const
 {
     const Results* results = m_results.value(view, 0);
@@ -27,6 +27,7 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include <QCache>
 #include <QFutureWatcher>
 #include <QRectF>
+#include <QVector>
 
 namespace qpdfview
 {
@@ -68,6 +69,7 @@ public:
 
     bool hasResults(DocumentView* view) const;
     bool hasResultsOnPage(DocumentView* view, int page) const;
+    QVector< int > pagesWithResults(DocumentView* view) const;
     int numberOfResultsOnPage(DocumentView* view, int page) const;
     QList< QRectF > resultsOnPage(DocumentView* view, int page) const;
 
@@ -21,7 +21,11 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "searchtask.h"
 
+#include <QCoreApplication>
+#include <QThreadPool>
+
 #include "model.h"
+#include "searchindex.h"
 
 namespace
 {
@@ -124,19 +128,69 @@ int loadProgress(const QAtomicInt& progress)
 #endif // QT_VERSION
 }
 
+// small enough that the searches of several documents take turns and canceling one waits only for a few pages
+
+const int pagesPerChunk = 4;
+
 } // anonymous
 
 namespace qpdfview
 {
 
+class SearchTask::Worker : public QRunnable
+{
+public:
+    Worker() : QRunnable()
+    {
+    }
+
+    void run()
+    {
+        int beginOffset = 0;
+        int endOffset = 0;
+
+        while(SearchTask* task = claimChunk(beginOffset, endOffset))
+        {
+            task->searchPages(beginOffset, endOffset);
+
+            releaseChunk(task);
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(Worker)
+
+};
+
+QThreadPool* SearchTask::s_threadPool = 0;
+
+QMutex SearchTask::s_mutex;
+QWaitCondition SearchTask::s_waitCondition;
+
+QList< SearchTask* > SearchTask::s_activeTasks;
+int SearchTask::s_nextTask = 0;
+int SearchTask::s_workerCount = 0;
+
 SearchTask::SearchTask(QObject* parent) : QThread(parent),
     m_wasCanceled(NotCanceled),
     m_progress(0),
     m_pages(),
     m_text(),
     m_matchCase(false),
-    m_beginAtPage(1)
+    m_beginAtPage(1),
+    m_searchIndex(0),
+    m_candidatePages(),
+    m_mutex(),
+    m_waitCondition(),
+    m_nextOffset(0),
+    m_runningChunks(0),
+    m_results(),
+    m_resultsReady()
 {
+    if(s_threadPool == 0)
+    {
+        s_threadPool = new QThreadPool(QCoreApplication::instance());
+    }
 }
 
 bool SearchTask::wasCanceled() const
@@ -151,27 +205,65 @@ int SearchTask::progress() const
 
 void SearchTask::run()
 {
-    for(int index = m_beginAtPage - 1; index < m_pages.count() + m_beginAtPage - 1; ++index)
+    const int pageCount = m_pages.count();
+
+    m_results.fill(QList< QRectF >(), pageCount);
+    m_resultsReady.fill(false, pageCount);
+
+    m_candidatePages = m_searchIndex != 0 ? m_searchIndex->candidatePages(m_text) : QVector< bool >();
+
+    if(m_candidatePages.count() != pageCount)
     {
+        m_candidatePages.clear();
+    }
+
+    // pages are claimed in order by the workers, but results are still reported in order starting at the first page
+
+    activate();
+
+    m_mutex.lock();
+
+    for(int offset = 0; offset < pageCount; ++offset)
+    {
+        while(!m_resultsReady.at(offset) && !testCancellation(m_wasCanceled))
+        {
+            m_waitCondition.wait(&m_mutex);
+        }
+
         if(testCancellation(m_wasCanceled))
         {
             break;
         }
 
-        const QList< QRectF > results = m_pages.at(index % m_pages.count())->search(m_text, m_matchCase);
+        const QList< QRectF > results = m_results.at(offset);
+        m_results[offset] = QList< QRectF >();
 
-        emit resultsReady(index % m_pages.count(), results);
+        m_mutex.unlock();
 
-        releaseProgress(m_progress, 100 * (index + 1 - m_beginAtPage + 1) / m_pages.count());
+        emit resultsReady((m_beginAtPage - 1 + offset) % pageCount, results);
+
+        releaseProgress(m_progress, 100 * (offset + 1) / pageCount);
 
         emit progressChanged(loadProgress(m_progress));
+
+        m_mutex.lock();
     }
 
+    m_mutex.unlock();
+
+    deactivate();
+
+    m_results.clear();
+    m_resultsReady.clear();
+
+    m_candidatePages.clear();
+
     releaseProgress(m_progress, 0);
 }
 
 void SearchTask::start(const QVector< Model::Page* >& pages,
-                       const QString& text, bool matchCase, int beginAtPage)
+                       const QString& text, bool matchCase, int beginAtPage,
+                       const SearchIndex* searchIndex)
 {
     m_pages = pages;
 
@@ -179,6 +271,8 @@ void SearchTask::start(const QVector< Model::Page* >& pages,
     m_matchCase = matchCase;
     m_beginAtPage = beginAtPage;
 
+    m_searchIndex = searchIndex;
+
     resetCancellation(m_wasCanceled);
     releaseProgress(m_progress, 0);
 
@@ -188,6 +282,112 @@ void SearchTask::start(const QVector< Model::Page* >& pages,
 void SearchTask::cancel()
 {
     setCancellation(m_wasCanceled);
+
+    m_mutex.lock();
+    m_waitCondition.wakeAll();
+    m_mutex.unlock();
+}
+
+void SearchTask::activate()
+{
+    QMutexLocker mutexLocker(&s_mutex);
+
+    m_nextOffset = 0;
+    m_runningChunks = 0;
+
+    s_activeTasks.append(this);
+
+    // queued workers do not refer to any search, so they can safely outlive this one
+
+    for(; s_workerCount < s_threadPool->maxThreadCount(); ++s_workerCount)
+    {
+        s_threadPool->start(new Worker);
+    }
+}
+
+void SearchTask::deactivate()
+{
+    QMutexLocker mutexLocker(&s_mutex);
+
+    s_activeTasks.removeOne(this);
+
+    // only chunks which are already being searched are waited for
+
+    while(m_runningChunks > 0)
+    {
+        s_waitCondition.wait(&s_mutex);
+    }
+}
+
+SearchTask* SearchTask::claimChunk(int& beginOffset, int& endOffset)
+{
+    QMutexLocker mutexLocker(&s_mutex);
+
+    while(!s_activeTasks.isEmpty())
+    {
+        if(s_nextTask >= s_activeTasks.count())
+        {
+            s_nextTask = 0;
+        }
+
+        SearchTask* const task = s_activeTasks.at(s_nextTask);
+
+        const int pageCount = task->m_pages.count();
+
+        if(task->m_nextOffset >= pageCount || testCancellation(task->m_wasCanceled))
+        {
+            s_activeTasks.removeAt(s_nextTask);
+
+            continue;
+        }
+
+        beginOffset = task->m_nextOffset;
+        endOffset = qMin(beginOffset + pagesPerChunk, pageCount);
+
+        task->m_nextOffset = endOffset;
+        ++task->m_runningChunks;
+
+        ++s_nextTask;
+
+        return task;
+    }
+
+    --s_workerCount;
+
+    return 0;
+}
+
+void SearchTask::releaseChunk(SearchTask* task)
+{
+    QMutexLocker mutexLocker(&s_mutex);
+
+    --task->m_runningChunks;
+
+    s_waitCondition.wakeAll();
+}
+
+void SearchTask::searchPages(int beginOffset, int endOffset)
+{
+    const int pageCount = m_pages.count();
+
+    for(int offset = beginOffset; offset < endOffset && !testCancellation(m_wasCanceled); ++offset)
+    {
+        const int index = (m_beginAtPage - 1 + offset) % pageCount;
+
+        QList< QRectF > results;
+
+        if(m_candidatePages.isEmpty() || m_candidatePages.at(index))
+        {
+            results = m_pages.at(index)->search(m_text, m_matchCase);
+        }
+
+        QMutexLocker mutexLocker(&m_mutex);
+
+        m_results[offset] = results;
+        m_resultsReady[offset] = true;
+
+        m_waitCondition.wakeAll();
+    }
 }
 
 } // qpdfview
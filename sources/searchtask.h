@@ -22,9 +22,14 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef SEARCHTASK_H
 #define SEARCHTASK_H
 
+#include <QList>
+#include <QMutex>
 #include <QRectF>
 #include <QThread>
 #include <QVector>
+#include <QWaitCondition>
+
+class QThreadPool;
 
 namespace qpdfview
 {
@@ -34,6 +39,8 @@ namespace Model
 class Page;
 }
 
+class SearchIndex;
+
 class SearchTask : public QThread
 {
     Q_OBJECT
@@ -56,13 +63,25 @@ signals:
 
 public slots:
     void start(const QVector< Model::Page* >& pages,
-               const QString& text, bool matchCase, int beginAtPage = 1);
+               const QString& text, bool matchCase, int beginAtPage = 1,
+               const SearchIndex* searchIndex = 0);
 
     void cancel();
 
 private:
     Q_DISABLE_COPY(SearchTask)
 
+    static QThreadPool* s_threadPool;
+
+    // the workers of the shared thread pool claim chunks of pages from the active searches in turn
+
+    static QMutex s_mutex;
+    static QWaitCondition s_waitCondition;
+
+    static QList< SearchTask* > s_activeTasks;
+    static int s_nextTask;
+    static int s_workerCount;
+
     QAtomicInt m_wasCanceled;
     mutable QAtomicInt m_progress;
 
@@ -72,6 +91,28 @@ private:
     bool m_matchCase;
     int m_beginAtPage;
 
+    const SearchIndex* m_searchIndex;
+    QVector< bool > m_candidatePages;
+
+    class Worker;
+
+    QMutex m_mutex;
+    QWaitCondition m_waitCondition;
+
+    int m_nextOffset;
+    int m_runningChunks;
+
+    QVector< QList< QRectF > > m_results;
+    QVector< bool > m_resultsReady;
+
+    void activate();
+    void deactivate();
+
+    static SearchTask* claimChunk(int& beginOffset, int& endOffset);
+    static void releaseChunk(SearchTask* task);
+
+    void searchPages(int beginOffset, int endOffset);
+
 };
 
 } // qpdfview
@@ -79,6 +79,7 @@ Settings::~Settings()
 void Settings::PageItem::sync()
 {
     m_cacheSize = m_settings->value("pageItem/cacheSize", Defaults::PageItem::cacheSize()).toInt();
+    m_diskCacheSize = m_settings->value("pageItem/diskCacheSize", Defaults::PageItem::diskCacheSize()).toInt();
 
     m_useTiling = m_settings->value("pageItem/useTiling", Defaults::PageItem::useTiling()).toBool();
     m_tileSize = m_settings->value("pageItem/tileSize", Defaults::PageItem::tileSize()).toInt();
@@ -87,6 +88,7 @@ void Settings::PageItem::sync()
     m_errorIcon = QIcon::fromTheme("image-missing", QIcon(":icons/image-missing.svg"));
 
     m_keepObsoletePixmaps = m_settings->value("pageItem/keepObsoletePixmaps", Defaults::PageItem::keepObsoletePixmaps()).toBool();
+    m_renderPreviews = m_settings->value("pageItem/renderPreviews", Defaults::PageItem::renderPreviews()).toBool();
     m_useDevicePixelRatio = m_settings->value("pageItem/useDevicePixelRatio", Defaults::PageItem::useDevicePixelRatio()).toBool();
 
     m_trimMargins = m_settings->value("pageItem/trimMargins", Defaults::PageItem::trimMargins()).toBool();
@@ -103,13 +105,22 @@ void Settings::PageItem::sync()
 
 void Settings::PageItem::setCacheSize(int cacheSize)
 {
-    if(cacheSize >= 0)
+    if(cacheSize >= -1)
     {
         m_cacheSize = cacheSize;
         m_settings->setValue("pageItem/cacheSize", cacheSize);
     }
 }
 
+void Settings::PageItem::setDiskCacheSize(int diskCacheSize)
+{
+    if(diskCacheSize >= 0)
+    {
+        m_diskCacheSize = diskCacheSize;
+        m_settings->setValue("pageItem/diskCacheSize", diskCacheSize);
+    }
+}
+
 void Settings::PageItem::setUseTiling(bool useTiling)
 {
     m_useTiling = useTiling;
@@ -122,6 +133,12 @@ void Settings::PageItem::setKeepObsoletePixmaps(bool keepObsoletePixmaps)
     m_settings->setValue("pageItem/keepObsoletePixmaps", keepObsoletePixmaps);
 }
 
+void Settings::PageItem::setRenderPreviews(bool renderPreviews)
+{
+    m_renderPreviews = renderPreviews;
+    m_settings->setValue("pageItem/renderPreviews", renderPreviews);
+}
+
 void Settings::PageItem::setUseDevicePixelRatio(bool useDevicePixelRatio)
 {
     m_useDevicePixelRatio = useDevicePixelRatio;
@@ -233,9 +250,11 @@ void Settings::PageItem::setFormFieldOverlay(bool overlay)
 Settings::PageItem::PageItem(QSettings* settings) :
     m_settings(settings),
     m_cacheSize(Defaults::PageItem::cacheSize()),
+    m_diskCacheSize(Defaults::PageItem::diskCacheSize()),
     m_progressIcon(),
     m_errorIcon(),
     m_keepObsoletePixmaps(Defaults::PageItem::keepObsoletePixmaps()),
+    m_renderPreviews(Defaults::PageItem::renderPreviews()),
     m_useDevicePixelRatio(false),
     m_trimMargins(false),
     m_decoratePages(Defaults::PageItem::decoratePages()),
@@ -303,6 +322,8 @@ void Settings::DocumentView::sync()
     m_highlightCurrentThumbnail = m_settings->value("documentView/highlightCurrentThumbnail", Defaults::DocumentView::highlightCurrentThumbnail()).toBool();
     m_limitThumbnailsToResults = m_settings->value("documentView/limitThumbnailsToResults", Defaults::DocumentView::limitThumbnailsToResults()).toBool();
 
+    m_showRenderStatistics = m_settings->value("documentView/showRenderStatistics", Defaults::DocumentView::showRenderStatistics()).toBool();
+
     m_pageSpacing = m_settings->value("documentView/pageSpacing", Defaults::DocumentView::pageSpacing()).toReal();
     m_thumbnailSpacing = m_settings->value("documentView/thumbnailSpacing", Defaults::DocumentView::thumbnailSpacing()).toReal();
 
@@ -375,6 +396,12 @@ void Settings::DocumentView::setLimitThumbnailsToResults(bool limitThumbnailsToR
     m_settings->setValue("documentView/limitThumbnailsToResults", limitThumbnailsToResults);
 }
 
+void Settings::DocumentView::setShowRenderStatistics(bool showRenderStatistics)
+{
+    m_showRenderStatistics = showRenderStatistics;
+    m_settings->setValue("documentView/showRenderStatistics", showRenderStatistics);
+}
+
 qreal Settings::DocumentView::minimumScaleFactor() const
 {
     return m_settings->value("documentView/minimumScaleFactor", Defaults::DocumentView::minimumScaleFactor()).toReal();
@@ -584,6 +611,7 @@ Settings::DocumentView::DocumentView(QSettings *settings) :
     m_pagesPerRow(Defaults::DocumentView::pagesPerRow()),
     m_highlightCurrentThumbnail(Defaults::DocumentView::highlightCurrentThumbnail()),
     m_limitThumbnailsToResults(Defaults::DocumentView::limitThumbnailsToResults()),
+    m_showRenderStatistics(Defaults::DocumentView::showRenderStatistics()),
     m_pageSpacing(Defaults::DocumentView::pageSpacing()),
     m_thumbnailSpacing(Defaults::DocumentView::thumbnailSpacing()),
     m_thumbnailSize(Defaults::DocumentView::thumbnailSize())
@@ -672,6 +700,16 @@ void Settings::MainWindow::setRestorePerFileSettings(bool restorePerFileSettings
     m_settings->setValue("mainWindow/restorePerFileSettings", restorePerFileSettings);
 }
 
+bool Settings::MainWindow::restoreSearchIndex() const
+{
+    return m_settings->value("mainWindow/restoreSearchIndex", Defaults::MainWindow::restoreSearchIndex()).toBool();
+}
+
+void Settings::MainWindow::setRestoreSearchIndex(bool restoreSearchIndex)
+{
+    m_settings->setValue("mainWindow/restoreSearchIndex", restoreSearchIndex);
+}
+
 int Settings::MainWindow::saveDatabaseInterval() const
 {
     return m_settings->value("mainWindow/saveDatabaseInterval", Defaults::MainWindow::saveDatabaseInterval()).toInt();
@@ -55,6 +55,9 @@ public:
         inline int cacheSize() const { return m_cacheSize; }
         void setCacheSize(int cacheSize);
 
+        inline int diskCacheSize() const { return m_diskCacheSize; }
+        void setDiskCacheSize(int diskCacheSize);
+
         inline bool useTiling() const { return m_useTiling; }
         void setUseTiling(bool useTiling);
 
@@ -66,6 +69,9 @@ public:
         inline bool keepObsoletePixmaps() const { return m_keepObsoletePixmaps; }
         void setKeepObsoletePixmaps(bool keepObsoletePixmaps);
 
+        inline bool renderPreviews() const { return m_renderPreviews; }
+        void setRenderPreviews(bool renderPreviews);
+
         inline bool useDevicePixelRatio() const { return m_useDevicePixelRatio; }
         void setUseDevicePixelRatio(bool useDevicePixelRatio);
 
@@ -115,6 +121,7 @@ public:
         QSettings* m_settings;
 
         int m_cacheSize;
+        int m_diskCacheSize;
 
         bool m_useTiling;
         int m_tileSize;
@@ -123,6 +130,7 @@ public:
         QIcon m_errorIcon;
 
         bool m_keepObsoletePixmaps;
+        bool m_renderPreviews;
         bool m_useDevicePixelRatio;
 
         bool m_trimMargins;
@@ -192,6 +200,9 @@ public:
         inline bool limitThumbnailsToResults() const { return m_limitThumbnailsToResults; }
         void setLimitThumbnailsToResults(bool limitThumbnailsToResults);
 
+        inline bool showRenderStatistics() const { return m_showRenderStatistics; }
+        void setShowRenderStatistics(bool showRenderStatistics);
+
         qreal minimumScaleFactor() const;
         qreal maximumScaleFactor() const;
 
@@ -268,6 +279,8 @@ public:
         bool m_highlightCurrentThumbnail;
         bool m_limitThumbnailsToResults;
 
+        bool m_showRenderStatistics;
+
         qreal m_pageSpacing;
         qreal m_thumbnailSpacing;
 
@@ -304,6 +317,9 @@ public:
         bool restorePerFileSettings() const;
         void setRestorePerFileSettings(bool restorePerFileSettings);
 
+        bool restoreSearchIndex() const;
+        void setRestoreSearchIndex(bool restoreSearchIndex);
+
         int saveDatabaseInterval() const;
         void setSaveDatabaseInterval(int saveDatabaseInterval);
 
@@ -466,12 +482,14 @@ public:
     class PageItem
     {
     public:
-        static inline int cacheSize() { return 32 * 1024 * 1024; }
+        static inline int cacheSize() { return -1; }
+        static inline int diskCacheSize() { return 0; }
 
         static inline bool useTiling() { return false; }
         static inline int tileSize() { return 1024; }
 
         static inline bool keepObsoletePixmaps() { return false; }
+        static inline bool renderPreviews() { return true; }
         static inline bool useDevicePixelRatio() { return false; }
 
         static inline bool trimMargins() { return false; }
@@ -530,6 +548,8 @@ public:
         static inline bool highlightCurrentThumbnail() { return false; }
         static inline bool limitThumbnailsToResults() { return false; }
 
+        static inline bool showRenderStatistics() { return false; }
+
         static inline qreal minimumScaleFactor() { return 0.1; }
         static inline qreal maximumScaleFactor() { return 50.0; }
 
@@ -585,6 +605,7 @@ public:
         static inline bool restoreTabs() { return false; }
         static inline bool restoreBookmarks() { return false; }
         static inline bool restorePerFileSettings() { return false; }
+        static inline bool restoreSearchIndex() { return false; }
 
         static inline int saveDatabaseInterval() { return 5 * 60 * 1000; }
 
@@ -267,6 +267,13 @@ void SettingsDialog::createBehaviorTab()
 
     m_behaviorLayout->addRow(tr("Restore per-file settings:"), m_restorePerFileSettingsCheckBox);
 
+    // restore search index
+
+    m_restoreSearchIndexCheckBox = new QCheckBox(this);
+    m_restoreSearchIndexCheckBox->setChecked(s_settings->mainWindow().restoreSearchIndex());
+
+    m_behaviorLayout->addRow(tr("Restore search index:"), m_restoreSearchIndexCheckBox);
+
     // save database interval
 
     m_saveDatabaseInterval = new QSpinBox(this);
@@ -282,6 +289,7 @@ void SettingsDialog::createBehaviorTab()
     m_restoreTabsCheckBox->setEnabled(false);
     m_restoreBookmarksCheckBox->setEnabled(false);
     m_restorePerFileSettingsCheckBox->setEnabled(false);
+    m_restoreSearchIndexCheckBox->setEnabled(false);
     m_saveDatabaseInterval->setEnabled(false);
 
 #endif // WITH_SQL
@@ -362,6 +370,7 @@ void SettingsDialog::acceptBehaivorTab()
     s_settings->mainWindow().setRestoreTabs(m_restoreTabsCheckBox->isChecked());
     s_settings->mainWindow().setRestoreBookmarks(m_restoreBookmarksCheckBox->isChecked());
     s_settings->mainWindow().setRestorePerFileSettings(m_restorePerFileSettingsCheckBox->isChecked());
+    s_settings->mainWindow().setRestoreSearchIndex(m_restoreSearchIndexCheckBox->isChecked());
     s_settings->mainWindow().setSaveDatabaseInterval(m_saveDatabaseInterval->value() * 60 * 1000);
 
     s_settings->presentationView().setSynchronize(m_synchronizePresentationCheckBox->isChecked());
@@ -390,6 +399,7 @@ void SettingsDialog::resetBehaviorTab()
     m_restoreTabsCheckBox->setChecked(Defaults::MainWindow::restoreTabs());
     m_restoreBookmarksCheckBox->setChecked(Defaults::MainWindow::restoreBookmarks());
     m_restorePerFileSettingsCheckBox->setChecked(Defaults::MainWindow::restorePerFileSettings());
+    m_restoreSearchIndexCheckBox->setChecked(Defaults::MainWindow::restoreSearchIndex());
     m_saveDatabaseInterval->setValue(Defaults::MainWindow::saveDatabaseInterval());
 
     m_synchronizePresentationCheckBox->setChecked(Defaults::PresentationView::synchronize());
@@ -422,6 +432,13 @@ void SettingsDialog::createGraphicsTab()
 
     m_graphicsLayout->addRow(tr("Keep obsolete pixmaps:"), m_keepObsoletePixmapsCheckBox);
 
+    // render previews
+
+    m_renderPreviewsCheckBox = new QCheckBox(this);
+    m_renderPreviewsCheckBox->setChecked(s_settings->pageItem().renderPreviews());
+
+    m_graphicsLayout->addRow(tr("Render previews:"), m_renderPreviewsCheckBox);
+
 #if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
 
     // use device pixel ratio
@@ -520,6 +537,7 @@ void SettingsDialog::createGraphicsTab()
     // cache size
 
     m_cacheSizeComboBox = new QComboBox(this);
+    m_cacheSizeComboBox->addItem(tr("Automatic"), -1);
     m_cacheSizeComboBox->addItem(tr("%1 MB").arg(0), 0);
     m_cacheSizeComboBox->addItem(tr("%1 MB").arg(8), 8 * 1024 * 1024);
     m_cacheSizeComboBox->addItem(tr("%1 MB").arg(16), 16 * 1024 * 1024);
@@ -545,6 +563,31 @@ void SettingsDialog::createGraphicsTab()
 
     m_graphicsLayout->addRow(tr("Cache size:"), m_cacheSizeComboBox);
 
+    // disk cache size
+
+    m_diskCacheSizeComboBox = new QComboBox(this);
+    m_diskCacheSizeComboBox->addItem(tr("None"), 0);
+    m_diskCacheSizeComboBox->addItem(tr("%1 MB").arg(64), 64 * 1024 * 1024);
+    m_diskCacheSizeComboBox->addItem(tr("%1 MB").arg(128), 128 * 1024 * 1024);
+    m_diskCacheSizeComboBox->addItem(tr("%1 MB").arg(256), 256 * 1024 * 1024);
+    m_diskCacheSizeComboBox->addItem(tr("%1 MB").arg(512), 512 * 1024 * 1024);
+    m_diskCacheSizeComboBox->addItem(tr("%1 MB").arg(1024), 1073741823);
+    m_diskCacheSizeComboBox->addItem(tr("%1 MB").arg(2048), 2147483647);
+
+    const int diskCacheSize = s_settings->pageItem().diskCacheSize();
+    int diskCacheSizeIndex = m_diskCacheSizeComboBox->findData(diskCacheSize);
+
+    if(diskCacheSizeIndex == -1)
+    {
+        m_diskCacheSizeComboBox->addItem(tr("%1 MB").arg(diskCacheSize / 1024 / 1024), diskCacheSize);
+
+        diskCacheSizeIndex = m_diskCacheSizeComboBox->count() - 1;
+    }
+
+    m_diskCacheSizeComboBox->setCurrentIndex(diskCacheSizeIndex);
+
+    m_graphicsLayout->addRow(tr("Disk cache size:"), m_diskCacheSizeComboBox);
+
     // prefetch
 
     m_prefetchCheckBox = new QCheckBox(this);
@@ -557,6 +600,7 @@ void SettingsDialog::createGraphicsTab()
     m_prefetchDistanceSpinBox = new QSpinBox(this);
     m_prefetchDistanceSpinBox->setRange(1, 10);
     m_prefetchDistanceSpinBox->setValue(s_settings->documentView().prefetchDistance());
+    m_prefetchDistanceSpinBox->setToolTip(tr("Rows of pages rendered in advance around the current one or, while scrolling, ahead of the viewport."));
 
     m_graphicsLayout->addRow(tr("Prefetch distance:"), m_prefetchDistanceSpinBox);
 }
@@ -565,6 +609,7 @@ void SettingsDialog::acceptGraphicsTab()
 {
     s_settings->pageItem().setUseTiling(m_useTilingCheckBox->isChecked());
     s_settings->pageItem().setKeepObsoletePixmaps(m_keepObsoletePixmapsCheckBox->isChecked());
+    s_settings->pageItem().setRenderPreviews(m_renderPreviewsCheckBox->isChecked());
 
 #if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
 
@@ -590,6 +635,7 @@ void SettingsDialog::acceptGraphicsTab()
     s_settings->documentView().setThumbnailSize(m_thumbnailSizeSpinBox->value());
 
     s_settings->pageItem().setCacheSize(m_cacheSizeComboBox->itemData(m_cacheSizeComboBox->currentIndex()).toInt());
+    s_settings->pageItem().setDiskCacheSize(m_diskCacheSizeComboBox->itemData(m_diskCacheSizeComboBox->currentIndex()).toInt());
     s_settings->documentView().setPrefetch(m_prefetchCheckBox->isChecked());
     s_settings->documentView().setPrefetchDistance(m_prefetchDistanceSpinBox->value());
 
@@ -613,6 +659,7 @@ void SettingsDialog::resetGraphicsTab()
 {
     m_useTilingCheckBox->setChecked(Defaults::PageItem::useTiling());
     m_keepObsoletePixmapsCheckBox->setChecked(Defaults::PageItem::keepObsoletePixmaps());
+    m_renderPreviewsCheckBox->setChecked(Defaults::PageItem::renderPreviews());
 
 #if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
 
@@ -638,6 +685,7 @@ void SettingsDialog::resetGraphicsTab()
     m_thumbnailSizeSpinBox->setValue(Defaults::DocumentView::thumbnailSize());
 
     m_cacheSizeComboBox->setCurrentIndex(m_cacheSizeComboBox->findData(Defaults::PageItem::cacheSize()));
+    m_diskCacheSizeComboBox->setCurrentIndex(m_diskCacheSizeComboBox->findData(Defaults::PageItem::diskCacheSize()));
     m_prefetchCheckBox->setChecked(Defaults::DocumentView::prefetch());
     m_prefetchDistanceSpinBox->setValue(Defaults::DocumentView::prefetchDistance());
 
@@ -821,6 +869,13 @@ void SettingsDialog::createInterfaceTab()
     m_limitThumbnailsToResultsCheckBox->setChecked(s_settings->documentView().limitThumbnailsToResults());
 
     m_interfaceLayout->addRow(tr("Limit thumbnails to results:"), m_limitThumbnailsToResultsCheckBox);
+
+    // show render statistics
+
+    m_showRenderStatisticsCheckBox = new QCheckBox(this);
+    m_showRenderStatisticsCheckBox->setChecked(s_settings->documentView().showRenderStatistics());
+
+    m_interfaceLayout->addRow(tr("Show render statistics:"), m_showRenderStatisticsCheckBox);
 }
 
 void SettingsDialog::acceptInterfaceTab()
@@ -855,6 +910,8 @@ void SettingsDialog::acceptInterfaceTab()
 
     s_settings->documentView().setHighlightCurrentThumbnail(m_highlightCurrentThumbnailCheckBox->isChecked());
     s_settings->documentView().setLimitThumbnailsToResults(m_limitThumbnailsToResultsCheckBox->isChecked());
+
+    s_settings->documentView().setShowRenderStatistics(m_showRenderStatisticsCheckBox->isChecked());
 }
 
 void SettingsDialog::resetInterfaceTab()
@@ -889,6 +946,8 @@ void SettingsDialog::resetInterfaceTab()
 
     m_highlightCurrentThumbnailCheckBox->setChecked(Defaults::DocumentView::highlightCurrentThumbnail());
     m_limitThumbnailsToResultsCheckBox->setChecked(Defaults::DocumentView::limitThumbnailsToResults());
+
+    m_showRenderStatisticsCheckBox->setChecked(Defaults::DocumentView::showRenderStatistics());
 }
 
 void SettingsDialog::createModifiersTab()
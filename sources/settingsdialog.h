@@ -89,6 +89,7 @@ private:
     QCheckBox* m_restoreTabsCheckBox;
     QCheckBox* m_restoreBookmarksCheckBox;
     QCheckBox* m_restorePerFileSettingsCheckBox;
+    QCheckBox* m_restoreSearchIndexCheckBox;
     QSpinBox* m_saveDatabaseInterval;
 
     QCheckBox* m_synchronizePresentationCheckBox;
@@ -112,6 +113,7 @@ private:
 
     QCheckBox* m_useTilingCheckBox;
     QCheckBox* m_keepObsoletePixmapsCheckBox;
+    QCheckBox* m_renderPreviewsCheckBox;
 
 #if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
 
@@ -137,6 +139,7 @@ private:
     QDoubleSpinBox* m_thumbnailSizeSpinBox;
 
     QComboBox* m_cacheSizeComboBox;
+    QComboBox* m_diskCacheSizeComboBox;
     QCheckBox* m_prefetchCheckBox;
     QSpinBox* m_prefetchDistanceSpinBox;
 
@@ -177,6 +180,8 @@ private:
     QCheckBox* m_highlightCurrentThumbnailCheckBox;
     QCheckBox* m_limitThumbnailsToResultsCheckBox;
 
+    QCheckBox* m_showRenderStatisticsCheckBox;
+
     void createInterfaceTab();
     void acceptInterfaceTab();
     void resetInterfaceTab();
@@ -24,6 +24,7 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include <QGraphicsSceneMouseEvent>
 #include <qmath.h>
 #include <QPainter>
+#include <QTimer>
 #include <QWidget>
 
 namespace qpdfview
@@ -34,19 +35,13 @@ ThumbnailItem::ThumbnailItem(Model::Page* page, const QString& text, int index,
     m_isHighlighted(false)
 {
     setAcceptHoverEvents(false);
+
+    QTimer::singleShot(0, this, SLOT(prepareToolTip()));
 }
 
 QRectF ThumbnailItem::boundingRect() const
 {
-#if QT_VERSION >= QT_VERSION_CHECK(4,7,0)
-
-    return PageItem::boundingRect().adjusted(0.0, 0.0, 0.0, 2.0 * m_text.size().height());
-
-#else
-
-    return PageItem::boundingRect().adjusted(0.0, 0.0, 0.0, 2.0 * QFontMetrics(QFont()).height());
-
-#endif // QT_VERSION
+    return PageItem::boundingRect().adjusted(0.0, 0.0, 0.0, textHeight());
 }
 
 void ThumbnailItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
@@ -97,6 +92,19 @@ void ThumbnailItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* opt
     }
 }
 
+qreal ThumbnailItem::textHeight() const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(4,7,0)
+
+    return 2.0 * m_text.size().height();
+
+#else
+
+    return 2.0 * QFontMetrics(QFont()).height();
+
+#endif // QT_VERSION
+}
+
 void ThumbnailItem::setHighlighted(bool highlighted)
 {
     if(m_isHighlighted != highlighted)
@@ -137,7 +145,7 @@ void ThumbnailItem::contextMenuEvent(QGraphicsSceneContextMenuEvent*)
 {
 }
 
-void ThumbnailItem::loadInteractiveElements()
+void ThumbnailItem::prepareToolTip()
 {
     const qreal width = size().width() / 72.0 * 25.4;
     const qreal height = size().height() / 72.0 * 25.4;
@@ -62,6 +62,8 @@ public:
 
 #endif // QT_VERSION
 
+    qreal textHeight() const;
+
     inline bool isHighlighted() const { return m_isHighlighted; }
     void setHighlighted(bool highlighted);
 
@@ -74,7 +76,7 @@ protected:
     void contextMenuEvent(QGraphicsSceneContextMenuEvent*);
 
 private slots:
-    void loadInteractiveElements();
+    void prepareToolTip();
 
 private:
     Q_DISABLE_COPY(ThumbnailItem)
@@ -27,13 +27,92 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include "settings.h"
 #include "rendertask.h"
 #include "pageitem.h"
+#include "memorymanager.h"
+#include "renderstatistics.h"
+
+namespace
+{
+
+inline uint combineHash(uint seed, uint value)
+{
+    return seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+inline uint hashReal(qreal value)
+{
+    uint hash = 0;
+    const uchar* bytes = reinterpret_cast< const uchar* >(&value);
+
+    for(unsigned int index = 0; index < sizeof(qreal); ++index)
+    {
+        hash = 31 * hash + bytes[index];
+    }
+
+    return hash;
+}
+
+inline int pixmapCost(const QPixmap& pixmap)
+{
+    return pixmap.width() * pixmap.height() * pixmap.depth() / 8;
+}
+
+} // anonymous
 
 namespace qpdfview
 {
 
 Settings* TileItem::s_settings = 0;
 
+// the key index is defined first so that it outlives the cache objects referring to it
+
+QHash< PageItem*, QSet< TileItem::CacheKey > > TileItem::s_cacheKeys;
 QCache< TileItem::CacheKey, TileItem::CacheObject > TileItem::s_cache;
+QCache< TileItem::CacheKey, TileItem::CacheObject > TileItem::s_thumbnailCache;
+
+int TileItem::s_obsoletePixmapCost = 0;
+
+TileItem::CacheKey::CacheKey(PageItem* page, const RenderParam& renderParam, const QRect& rect, bool preview) :
+    page(page),
+    renderParam(renderParam),
+    rect(rect),
+    preview(preview),
+    hash(0)
+{
+    hash = combineHash(hash, qHash(page));
+    hash = combineHash(hash, qHash(renderParam.resolution.resolutionX));
+    hash = combineHash(hash, qHash(renderParam.resolution.resolutionY));
+    hash = combineHash(hash, hashReal(renderParam.resolution.devicePixelRatio));
+    hash = combineHash(hash, hashReal(renderParam.scaleFactor));
+    hash = combineHash(hash, qHash(static_cast< int >(renderParam.rotation)));
+    hash = combineHash(hash, qHash((renderParam.invertColors ? 1 : 0) | (renderParam.convertToGrayscale ? 2 : 0)));
+    hash = combineHash(hash, qHash(rect.x()));
+    hash = combineHash(hash, qHash(rect.y()));
+    hash = combineHash(hash, qHash(rect.width()));
+    hash = combineHash(hash, qHash(rect.height()));
+    hash = combineHash(hash, qHash(preview ? 1 : 0));
+}
+
+TileItem::CacheObject::CacheObject(const CacheKey& key, const QPixmap& pixmap, const QRectF& cropRect) :
+    key(key),
+    pixmap(pixmap),
+    cropRect(cropRect)
+{
+}
+
+TileItem::CacheObject::~CacheObject()
+{
+    QHash< PageItem*, QSet< CacheKey > >::iterator keys = s_cacheKeys.find(key.page);
+
+    if(keys != s_cacheKeys.end())
+    {
+        keys->remove(key);
+
+        if(keys->isEmpty())
+        {
+            s_cacheKeys.erase(keys);
+        }
+    }
+}
 
 TileItem::TileItem(QObject* parent) : QObject(parent),
     m_rect(),
@@ -48,18 +127,21 @@ TileItem::TileItem(QObject* parent) : QObject(parent),
         s_settings = Settings::instance();
     }
 
-    s_cache.setMaxCost(s_settings->pageItem().cacheSize());
+    updateCacheBudgets();
 
     m_renderTask = new RenderTask(parentPage()->m_page, this);
 
     connect(m_renderTask, SIGNAL(finished()), SLOT(on_renderTask_finished()));
     connect(m_renderTask, SIGNAL(imageReady(RenderParam,QRect,bool,QImage,QRectF)), SLOT(on_renderTask_imageReady(RenderParam,QRect,bool,QImage,QRectF)));
+    connect(m_renderTask, SIGNAL(previewReady(RenderParam,QRect,QImage)), SLOT(on_renderTask_previewReady(RenderParam,QRect,QImage)));
 }
 
 TileItem::~TileItem()
 {
     m_renderTask->cancel(true);
     m_renderTask->wait();
+
+    setObsoletePixmap(QPixmap());
 }
 
 void TileItem::setCropRect(const QRectF& cropRect)
@@ -79,18 +161,24 @@ void TileItem::setCropRect(const QRectF& cropRect)
 
 void TileItem::dropCachedPixmaps(PageItem* page)
 {
-    foreach(CacheKey key, s_cache.keys())
+    foreach(const CacheKey& key, s_cacheKeys.value(page))
     {
-        if(key.first == page)
-        {
-            s_cache.remove(key);
-        }
+        cache(page).remove(key);
     }
+
+    s_cacheKeys.remove(page);
+}
+
+void TileItem::updateCacheBudgets()
+{
+    s_cache.setMaxCost(MemoryManager::instance()->tileBudget());
+    s_thumbnailCache.setMaxCost(MemoryManager::instance()->thumbnailBudget());
 }
 
 void TileItem::paint(QPainter* painter, const QPointF& topLeft)
 {
     const QPixmap& pixmap = takePixmap();
+    const CacheObject* preview = pixmap.isNull() ? cache(parentPage()).object(cacheKey(true)) : 0;
 
     if(!pixmap.isNull())
     {
@@ -104,6 +192,12 @@ void TileItem::paint(QPainter* painter, const QPointF& topLeft)
 
         painter->drawPixmap(QRectF(m_rect).translated(topLeft), m_obsoletePixmap, QRectF());
     }
+    else if(preview != 0)
+    {
+        // preview pixmap
+
+        painter->drawPixmap(QRectF(m_rect).translated(topLeft), preview->pixmap, QRectF());
+    }
     else
     {
         const qreal iconExtent = qMin(0.1 * m_rect.width(), 0.1 * m_rect.height());
@@ -130,16 +224,18 @@ void TileItem::refresh(bool keepObsoletePixmaps)
 {
     if(keepObsoletePixmaps && s_settings->pageItem().keepObsoletePixmaps())
     {
-        CacheObject* object = s_cache.object(cacheKey());
+        CacheObject* object = cache(parentPage()).object(cacheKey());
 
-        if(object != 0)
+        // obsolete pixmaps are only kept as long as they fit into their own budget
+
+        if(object != 0 && s_obsoletePixmapCost - pixmapCost(m_obsoletePixmap) + pixmapCost(object->pixmap) <= MemoryManager::instance()->obsoletePixmapBudget())
         {
-            m_obsoletePixmap = object->first;
+            setObsoletePixmap(object->pixmap);
         }
     }
     else
     {
-        m_obsoletePixmap = QPixmap();
+        setObsoletePixmap(QPixmap());
     }
 
     if(!keepObsoletePixmaps)
@@ -155,24 +251,31 @@ void TileItem::refresh(bool keepObsoletePixmaps)
 
 int TileItem::startRender(bool prefetch)
 {
-    if(m_pixmapError || m_renderTask->isRunning() || (prefetch && s_cache.contains(cacheKey())))
+    if(m_pixmapError || m_renderTask->isRunning() || (prefetch && cache(parentPage()).contains(cacheKey())))
     {
         return 0;
     }
 
-    m_renderTask->start(parentPage()->m_renderParam,
-                        m_rect, prefetch,
-                        s_settings->pageItem().trimMargins(), s_settings->pageItem().paperColor());
+    PageItem* page = parentPage();
+
+    const bool renderPreview = s_settings->pageItem().renderPreviews() && !page->thumbnailMode()
+            && m_obsoletePixmap.isNull() && !cache(page).contains(cacheKey(true));
+
+    m_renderTask->start(page->m_renderParam,
+                        m_rect, prefetch, renderPreview, page->thumbnailMode(),
+                        s_settings->pageItem().trimMargins(), s_settings->pageItem().paperColor(),
+                        page->m_diskCacheKey,
+                        page->m_renderScheduler, page->mapToScene(page->m_boundingRect.topLeft() + QRectF(m_rect).center()));
 
     return 1;
 }
 
-void TileItem::cancelRender()
+void TileItem::cancelRender(bool force)
 {
-    m_renderTask->cancel();
+    m_renderTask->cancel(force);
 
     m_pixmap = QPixmap();
-    m_obsoletePixmap = QPixmap();
+    setObsoletePixmap(QPixmap());
 }
 
 void TileItem::deleteAfterRender()
@@ -203,7 +306,7 @@ void TileItem::on_renderTask_imageReady(const RenderParam& renderParam,
         return;
     }
 
-    m_obsoletePixmap = QPixmap();
+    setObsoletePixmap(QPixmap());
 
     if(image.isNull())
     {
@@ -214,8 +317,7 @@ void TileItem::on_renderTask_imageReady(const RenderParam& renderParam,
 
     if(prefetch && !m_renderTask->wasCanceledForcibly())
     {
-        const int cost = image.width() * image.height() * image.depth() / 8;
-        s_cache.insert(cacheKey(), new CacheObject(QPixmap::fromImage(image), cropRect), cost);
+        insertCacheObject(cacheKey(), QPixmap::fromImage(image), cropRect);
 
         setCropRect(cropRect);
     }
@@ -227,54 +329,102 @@ void TileItem::on_renderTask_imageReady(const RenderParam& renderParam,
     }
 }
 
+void TileItem::on_renderTask_previewReady(const RenderParam& renderParam,
+                                          const QRect& rect,
+                                          QImage image)
+{
+    if(parentPage()->m_renderParam != renderParam || m_rect != rect)
+    {
+        return;
+    }
+
+    if(image.isNull() || m_renderTask->wasCanceled())
+    {
+        return;
+    }
+
+    insertCacheObject(cacheKey(true), QPixmap::fromImage(image), QRectF());
+
+    parentPage()->update();
+}
+
+inline QCache< TileItem::CacheKey, TileItem::CacheObject >& TileItem::cache(const PageItem* page)
+{
+    return page->thumbnailMode() ? s_thumbnailCache : s_cache;
+}
+
 inline PageItem* TileItem::parentPage() const
 {
     return qobject_cast< PageItem* >(parent());
 }
 
-inline TileItem::CacheKey TileItem::cacheKey() const
+inline TileItem::CacheKey TileItem::cacheKey(bool preview) const
 {
     PageItem* page = parentPage();
-    QByteArray key;
-
-    QDataStream(&key, QIODevice::WriteOnly)
-            << page->m_renderParam.resolution.resolutionX
-            << page->m_renderParam.resolution.resolutionY
-            << page->m_renderParam.scaleFactor
-            << page->m_renderParam.rotation
-            << page->m_renderParam.invertColors
-            << page->m_renderParam.convertToGrayscale
-            << m_rect;
-
-    return qMakePair(page, key);
+
+    return CacheKey(page, page->m_renderParam, m_rect, preview);
+}
+
+void TileItem::insertCacheObject(const CacheKey& key, const QPixmap& pixmap, const QRectF& cropRect)
+{
+    QCache< CacheKey, CacheObject >& objects = cache(key.page);
+
+    objects.insert(key, new CacheObject(key, pixmap, cropRect), pixmapCost(pixmap));
+
+    // replaced or rejected objects have already removed their key from the index
+
+    if(objects.contains(key))
+    {
+        s_cacheKeys[key.page].insert(key);
+    }
+
+    // a full-quality pixmap supersedes the preview and releases its cost
+
+    if(!key.preview)
+    {
+        objects.remove(CacheKey(key.page, key.renderParam, key.rect, true));
+    }
+}
+
+void TileItem::setObsoletePixmap(const QPixmap& obsoletePixmap)
+{
+    s_obsoletePixmapCost -= pixmapCost(m_obsoletePixmap);
+
+    m_obsoletePixmap = obsoletePixmap;
+
+    s_obsoletePixmapCost += pixmapCost(m_obsoletePixmap);
 }
 
 QPixmap TileItem::takePixmap()
 {
     const CacheKey key = cacheKey();
-    const CacheObject* object = s_cache.object(key);
+    const CacheObject* object = cache(parentPage()).object(key);
 
     if(object != 0)
     {
-        m_obsoletePixmap = QPixmap();
+        if(RenderStatistics::isEnabled())
+        {
+            RenderStatistics::instance()->addCacheLookup(parentPage()->thumbnailMode(), true);
+        }
 
-        setCropRect(object->second);
-        return object->first;
+        setObsoletePixmap(QPixmap());
+
+        setCropRect(object->cropRect);
+        return object->pixmap;
     }
 
     QPixmap pixmap;
 
     if(!m_pixmap.isNull())
     {
-        int cost = m_pixmap.width() * m_pixmap.height() * m_pixmap.depth() / 8;
-        s_cache.insert(key, new CacheObject(m_pixmap, m_cropRect), cost);
+        insertCacheObject(key, m_pixmap, m_cropRect);
 
         pixmap = m_pixmap;
         m_pixmap = QPixmap();
     }
-    else
+    else if(startRender() != 0 && RenderStatistics::isEnabled())
     {
-        startRender();
+        RenderStatistics::instance()->addCacheLookup(parentPage()->thumbnailMode(), false);
     }
 
     return pixmap;
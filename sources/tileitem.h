@@ -23,8 +23,10 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #define TILEITEM_H
 
 #include <QCache>
+#include <QHash>
 #include <QObject>
 #include <QPixmap>
+#include <QSet>
 
 #include "global.h"
 
@@ -50,9 +52,10 @@ public:
     void setCropRect(const QRectF& cropRect);
 
     inline void dropPixmap() { m_pixmap = QPixmap(); }
-    inline void dropObsoletePixmap() { m_obsoletePixmap = QPixmap(); }
+    inline void dropObsoletePixmap() { setObsoletePixmap(QPixmap()); }
 
     static void dropCachedPixmaps(PageItem* page);
+    static void updateCacheBudgets();
 
     void paint(QPainter* painter, const QPointF& topLeft);
 
@@ -60,7 +63,7 @@ public slots:
     void refresh(bool keepObsoletePixmaps = false);
 
     int startRender(bool prefetch = false);
-    void cancelRender();
+    void cancelRender(bool force = false);
 
     void deleteAfterRender();
 
@@ -69,19 +72,62 @@ protected slots:
     void on_renderTask_imageReady(const RenderParam& renderParam,
                                   const QRect& rect, bool prefetch,
                                   QImage image, QRectF cropRect);
+    void on_renderTask_previewReady(const RenderParam& renderParam,
+                                    const QRect& rect,
+                                    QImage image);
 
 private:
     Q_DISABLE_COPY(TileItem)
 
     static Settings* s_settings;
 
-    typedef QPair< PageItem*, QByteArray > CacheKey;
-    typedef QPair< QPixmap, QRectF > CacheObject;
+    struct CacheKey
+    {
+        PageItem* page;
+        RenderParam renderParam;
+        QRect rect;
+        bool preview;
 
+        uint hash;
+
+        CacheKey() : page(0), renderParam(), rect(), preview(false), hash(0) {}
+        CacheKey(PageItem* page, const RenderParam& renderParam, const QRect& rect, bool preview = false);
+
+        inline bool operator==(const CacheKey& other) const
+        {
+            return hash == other.hash
+                && page == other.page
+                && rect == other.rect
+                && preview == other.preview
+                && renderParam == other.renderParam;
+        }
+
+        friend inline uint qHash(const CacheKey& key) { return key.hash; }
+
+    };
+
+    struct CacheObject
+    {
+        CacheKey key;
+
+        QPixmap pixmap;
+        QRectF cropRect;
+
+        CacheObject(const CacheKey& key, const QPixmap& pixmap, const QRectF& cropRect);
+        ~CacheObject();
+
+    };
+
+    static QHash< PageItem*, QSet< CacheKey > > s_cacheKeys;
     static QCache< CacheKey, CacheObject > s_cache;
+    static QCache< CacheKey, CacheObject > s_thumbnailCache;
+
+    static QCache< CacheKey, CacheObject >& cache(const PageItem* page);
+
+    static void insertCacheObject(const CacheKey& key, const QPixmap& pixmap, const QRectF& cropRect);
 
     PageItem* parentPage() const;
-    CacheKey cacheKey() const;
+    CacheKey cacheKey(bool preview = false) const;
 
     QRect m_rect;
     QRectF m_cropRect;
@@ -90,6 +136,9 @@ private:
     QPixmap m_pixmap;
     QPixmap m_obsoletePixmap;
 
+    static int s_obsoletePixmapCost;
+    void setObsoletePixmap(const QPixmap& obsoletePixmap);
+
     QPixmap takePixmap();
 
     RenderTask* m_renderTask;